@@ -25,6 +25,8 @@ namespace fastsim
 	
 	Decayer();
 	~Decayer();
+	// the decay products have neither charge nor lifetime set,
+	// ParticleLooper sets them from the ParticlePropertyTable
 	void decay(const Particle & particle,std::vector<std::unique_ptr<Particle> > & secondaries,CLHEP::HepRandomEngine & engine) const;
 	
     private:
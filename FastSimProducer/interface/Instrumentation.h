@@ -0,0 +1,108 @@
+#ifndef FASTSIM_INSTRUMENTATION_H
+#define FASTSIM_INSTRUMENTATION_H
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace fastsim
+{
+    // Accumulates wall time, number of calls and number of produced secondaries
+    // for the navigation, the decays, each interaction model and each layer.
+    // One instance per stream, instances of different streams are merged at the end of the job.
+    // If disabled, all counters are 0 and the Timers do nothing:
+    // the cost of disabled instrumentation is a null pointer check per step.
+    // If enabled, each Timer reads the clock twice: on the navigation of charged particles
+    // (BM_LayerNavigator_Charged_Instrumentation in test/benchmarkFastSimCore.cpp) this about doubles the time per step,
+    // the times of the navigation and of cheap models are dominated by that overhead.
+    class Instrumentation
+    {
+    public:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Counter
+	{
+	    Counter() : seconds(0), calls(0), secondaries(0) {}
+	    Counter & operator+=(const Counter & other);
+	    double seconds;
+	    unsigned long long calls;
+	    unsigned long long secondaries;
+	};
+
+	// measures the time between construction and stop() (or destruction)
+	// and adds it as one call to the counter (if any)
+	class Timer
+	{
+	public:
+	    explicit Timer(Counter * counter)
+		: counter_(counter)
+	    {
+		if(counter_)
+		{
+		    start_ = Clock::now();
+		}
+	    }
+	    ~Timer()
+	    {
+		stop(0);
+	    }
+	    void stop(unsigned long long secondaries)
+	    {
+		if(counter_)
+		{
+		    counter_->seconds += std::chrono::duration<double>(Clock::now() - start_).count();
+		    counter_->calls++;
+		    counter_->secondaries += secondaries;
+		    counter_ = 0;
+		}
+	    }
+	private:
+	    Counter * counter_;
+	    Clock::time_point start_;
+	};
+
+	Instrumentation(bool enabled,const std::vector<std::string> & interactionModelNames);
+
+	bool enabled() const {return enabled_;}
+
+	// counters, 0 if disabled
+	Counter * navigation() {return enabled_ ? &navigation_ : 0;}
+	Counter * decay() {return enabled_ ? &decay_ : 0;}
+	Counter * interactionModel(unsigned index) {return enabled_ ? &interactionModels_[index] : 0;}
+	Counter * layer(bool isForward,unsigned index)
+	{
+	    if(!enabled_)
+	    {
+		return 0;
+	    }
+	    std::vector<Counter> & layers = isForward ? forwardLayers_ : barrelLayers_;
+	    if(index >= layers.size())
+	    {
+		layers.resize(index + 1);
+	    }
+	    return &layers[index];
+	}
+
+	// add the counters of another instance (with the same interaction models)
+	void merge(const Instrumentation & other);
+
+	// human readable summary
+	void print(std::ostream & os) const;
+
+	// machine readable summary: one line per counter
+	// <category> <name> <calls> <seconds> <secondaries>
+	void write(std::ostream & os) const;
+
+    private:
+	const bool enabled_;
+	std::vector<std::string> interactionModelNames_;
+	Counter navigation_;
+	Counter decay_;
+	std::vector<Counter> interactionModels_;
+	std::vector<Counter> barrelLayers_;
+	std::vector<Counter> forwardLayers_;
+    };
+}
+
+#endif
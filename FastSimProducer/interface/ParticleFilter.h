@@ -3,6 +3,10 @@
 
 #include "DataFormats/Math/interface/LorentzVector.h"
 
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
 namespace edm
 {
     class ParameterSet;
@@ -14,11 +18,56 @@ namespace fastsim
     class ParticleFilter
     {
     public:
+	// particles given as a structure of arrays, all of length size
+	struct Particles
+	{
+	    unsigned size;
+	    const int * pdgId;
+	    // 0: the charge is not set (see Particle::unsetCharge), the particles count as charged
+	    const double * charge;
+	    // origin vertex
+	    const double * x;
+	    const double * y;
+	    const double * z;
+	    const double * px;
+	    const double * py;
+	    const double * pz;
+	    const double * e;
+	};
+
 	ParticleFilter(const edm::ParameterSet & cfg);
 	bool accepts(const Particle & particle) const;
 	bool accepts(const math::XYZTLorentzVector & originVertexPosition) const;
+	// batch versions: accept[i] is set to 1 if the i-th particle is accepted, 0 otherwise
+	// over contiguous arrays (the gen particles, see ParticleLooper), the loop can be vectorized
+	void accepts(const Particles & particles,std::vector<unsigned char> & accept) const;
+	// the secondaries of an interaction or decay are separate Particle objects, a few per call:
+	// copying them into arrays first costs more than the cuts, the loop only avoids the branches
+	void accepts(const std::vector<std::unique_ptr<Particle> > & particles,std::vector<unsigned char> & accept) const;
 
     private:
+	// all cuts, evaluated without branches such that the batch loops can be vectorized
+	bool accepts(int pdgId,double charge,double x,double y,double z,double px,double py,double pz,double e) const
+	{
+	    int pId = std::abs(pdgId);
+	    double pt2 = px*px + py*py;
+	    double pz2 = pz*pz;
+	    double r2 = x*x + y*y;
+	    // invisible particles
+	    bool invisible = (pId == 12) | (pId == 14) | (pId == 16) | (pId == 1000022);
+	    // all high-energy protons are kept
+	    bool highEnergyProton = (pId == 2212) & (e >= protonEMin_);
+	    // cut on the energy
+	    bool energy = e >= EMin_;
+	    // cut on pt of charged particles
+	    bool chargedPt = (charge == 0) | (pt2 >= chargedPtMin2_);
+	    // cut on eta if the origin vertex is close to the beam
+	    bool eta = (r2 >= 25.) | (pz2 <= cos2ThetaMax_*(pt2 + pz2));
+	    // vertex in the volume enclosed by ECAL
+	    bool vertex = (r2 < vertexRMax2_) & (std::abs(z) < vertexZMax_);
+	    return !invisible & (highEnergyProton | (energy & chargedPt & eta & vertex));
+	}
+
 	// see constructor for comments
 	double chargedPtMin2_, EMin_, protonEMin_;
 	double cos2ThetaMax_;
@@ -4,45 +4,74 @@
 #include "DataFormats/Math/interface/LorentzVector.h"
 #include "HepMC/GenEvent.h"
 #include "vector"
+#include "deque"
+#include "unordered_map"
 #include "memory"
+#include "string"
 // TODO: TREAT PARTICLE FILTER PROPERLY
 
 #include "SimDataFormats/Track/interface/SimTrack.h"
 #include "SimDataFormats/Vertex/interface/SimVertex.h"
 
-namespace HepPDT
-{
-    class ParticleDataTable;
-}
-
 //class SimTrack;
 //class SimVertex;
-class RandomEngineAndDistribution;
+namespace CLHEP
+{
+    class HepRandomEngine;
+}
 
 namespace fastsim {
     class Particle;
     class ParticleFilter;
+    class RegionOfInterest;
+    class ParticlePropertyTable;
+    class Layer;
     class ParticleLooper
     {
 
     public:
 
+	// order in which the secondaries are handed out by nextParticle (before the next gen particle)
+	enum SchedulingPolicy
+	{
+	    DEPTHFIRST=0,    // last in, first out
+	    BREADTHFIRST,    // first in, first out
+	    ENERGYORDERED,   // highest energy first
+	    LAYERLOCALITY    // secondaries produced on the layer of the previous one first (last in, first out otherwise)
+	};
+	// policy from its name in the configuration: depthFirst, breadthFirst, energyOrdered, layerLocality
+	static SchedulingPolicy schedulingPolicy(const std::string & name);
+
 	ParticleLooper(
 	    const HepMC::GenEvent & genEvent,
-	    const HepPDT::ParticleDataTable & particleDataTable,
+	    const ParticlePropertyTable & particlePropertyTable,
 	    double beamPipeRadius,
 	    const ParticleFilter & particleFilter,
+	    const RegionOfInterest & regionOfInterest,
+	    SchedulingPolicy schedulingPolicy,
 	    std::unique_ptr<std::vector<SimTrack> > & simTracks,
 	    std::unique_ptr<std::vector<SimVertex> > & simVertices);
 	
+	// concurrent transport (see FastSimProducer): looper over the selected gen particles [begin,end) of eventLooper,
+	// with simTracks and simVertices of its own, that start with the main vertex of the event (if any)
+	ParticleLooper(const ParticleLooper & eventLooper,unsigned begin,unsigned end);
+
 	~ParticleLooper();
 
-	std::unique_ptr<Particle> nextParticle(const RandomEngineAndDistribution & random);
+	std::unique_ptr<Particle> nextParticle(CLHEP::HepRandomEngine & random);
 	
 	void addSecondaries(
 	    const math::XYZTLorentzVector & vertexPosition,
 	    int motherSimTrackId,
-	    std::vector<std::unique_ptr<Particle> > & secondaries);
+	    std::vector<std::unique_ptr<Particle> > & secondaries,
+	    const Layer * layer = 0); // layer on which the secondaries were produced, 0 if none (e.g. decays)
+
+	// number of gen particles to simulate
+	unsigned nGenParticles() const {return genParticles_.size();}
+
+	// concurrent transport: moves the simTracks and simVertices of a looper over a range of gen particles
+	// to the end of the ones of this looper, and returns the offset of their simTrack indices
+	int appendSimTracksAndVertices(ParticleLooper & taskLooper);
 
 	std::unique_ptr<std::vector<SimTrack> > harvestSimTracks()
 	{
@@ -63,23 +92,61 @@ namespace fastsim {
 	
 	unsigned addSimTrack(const Particle * particle);
 
+	void readGenParticles(const HepMC::GenEvent & genEvent);
+	void selectGenParticles();
 	std::unique_ptr<Particle> nextGenParticle();
+	std::unique_ptr<Particle> nextBufferedParticle();
+
+	// the gen particles of the event, in cms units, as a structure of arrays:
+	// filled once per event (readGenParticles), then reduced to the particles to simulate (selectGenParticles)
+	struct GenParticles
+	{
+	    void resize(unsigned size);
+	    void assign(const GenParticles & other,unsigned begin,unsigned end);
+	    unsigned size() const {return pdgId.size();}
+	    std::vector<int> pdgId;
+	    std::vector<int> genParticleIndex;
+	    // production vertex
+	    std::vector<double> x, y, z, t;
+	    std::vector<double> px, py, pz, e;
+	    // time from production to end vertex in the lab frame, 0 if the particle has no end vertex
+	    std::vector<double> labFrameLifeTime;
+	    // r^2 of the end vertex, -1 if the particle has no end vertex
+	    std::vector<double> endVertexR2;
+	};
 
 	// data members
 	const HepMC::GenEvent * const genEvent_;
-	HepMC::GenEvent::particle_const_iterator genParticleIterator_;
-	const HepMC::GenEvent::particle_const_iterator genParticleEnd_;
-	int genParticleIndex_;
-	const HepPDT::ParticleDataTable * const particleDataTable_;
+	GenParticles genParticles_;
+	unsigned nextGenParticle_;
+	const ParticlePropertyTable * const particlePropertyTable_;
 	const double beamPipeRadius2_;
 	const ParticleFilter * const particleFilter_;
+	// gen particles that cannot reach the region of interest are skipped, and with them all their secondaries
+	const RegionOfInterest * const regionOfInterest_;
 	std::unique_ptr<std::vector<SimTrack> > simTracks_;
 	std::unique_ptr<std::vector<SimVertex> > simVertices_;
+	// simVertices at the beginning of simVertices_ that are shared with the event looper (the main vertex)
+	unsigned nSharedSimVertices_;
 	double momentumUnitConversionFactor_;
 	double lengthUnitConversionFactor_;
 	double lengthUnitConversionFactor2_;
 	double timeUnitConversionFactor_;
-	std::vector<std::unique_ptr<Particle> > particleBuffer_;
+	// secondaries waiting to be simulated, with the layer they were produced on
+	struct BufferEntry
+	{
+	    std::unique_ptr<Particle> particle;
+	    const Layer * layer;
+	};
+	std::deque<BufferEntry> particleBuffer_;
+	const SchedulingPolicy schedulingPolicy_;
+	// layer of the last secondary handed out (LAYERLOCALITY)
+	const Layer * currentLayer_;
+	// LAYERLOCALITY: positions in particleBuffer_ of the secondaries of each layer, in increasing order
+	// entries handed out from the middle of the buffer are left empty, and removed once they reach its end
+	std::unordered_map<const Layer *,std::vector<unsigned> > layerBuckets_;
+	// acceptance mask of the particle filter (scratch)
+	std::vector<unsigned char> accept_;
     };
 }
 
@@ -0,0 +1,62 @@
+#ifndef FASTSIM_PARTICLEPROPERTYTABLE_H
+#define FASTSIM_PARTICLEPROPERTYTABLE_H
+
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+namespace HepPDT
+{
+    class ParticleDataTable;
+}
+
+namespace fastsim
+{
+    // flat copy of the particle properties needed during the simulation (charge, mean proper lifetime, stability)
+    // built once per run from the HepPDT::ParticleDataTable,
+    // such that no map lookup in the particle data table is needed per particle
+    // used by ParticleLooper::nextParticle for all particles that lack charge or lifetime,
+    // gen particles, secondaries and decay products alike:
+    // the Decayer itself does not look up charge or lifetime, Pythia8 decays with its own particle data
+    //
+    // pdg ids with |pdgId| < directSize_ (leptons, gauge bosons, most mesons and baryons)
+    // are looked up directly by index, the others in a small sorted vector
+    class ParticlePropertyTable
+    {
+    public:
+	struct Properties
+	{
+	    Properties() : charge(0), averageLifeTime(0), known(false), stable(true) {}
+	    double charge;
+	    // mean proper lifetime [ns], meaningless if stable
+	    double averageLifeTime;
+	    bool known;
+	    bool stable;
+	};
+
+	ParticlePropertyTable();
+
+	// (re)build the table
+	void update(const HepPDT::ParticleDataTable & particleDataTable);
+
+	// properties of a particle, 0 if the pdg id is unknown
+	const Properties * properties(int pdgId) const
+	{
+	    if(std::abs(pdgId) < directSize_)
+	    {
+		const Properties & properties = direct_[pdgId + directSize_];
+		return properties.known ? &properties : 0;
+	    }
+	    return otherProperties(pdgId);
+	}
+
+    private:
+	const Properties * otherProperties(int pdgId) const;
+
+	static const int directSize_ = 4096;
+	std::vector<Properties> direct_;
+	std::vector<std::pair<int,Properties> > other_;
+    };
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef FASTSIM_REGIONOFINTEREST_H
+#define FASTSIM_REGIONOFINTEREST_H
+
+#include "DataFormats/Math/interface/LorentzVector.h"
+
+#include <vector>
+
+namespace edm
+{
+    class ParameterSet;
+}
+
+namespace fastsim
+{
+    // a set of cones in eta/phi around which particles are transported (region of interest mode)
+    // the cones are either configured (cones) or created per event around seeds (see addCone)
+    //
+    // the test is done on the direction of the particle at its production vertex:
+    // a charged particle is accepted if any direction its track can bend to before the edge of the tracker
+    // (radius maxRadius, in the magnetic field magneticFieldZ, see setBending) lies within deltaR of a cone
+    class RegionOfInterest
+    {
+    public:
+	RegionOfInterest(const edm::ParameterSet & cfg);
+
+	// disabled: all particles are accepted
+	bool enabled() const {return enabled_;}
+
+	// remove the cones added with addCone, keep the configured ones
+	void clear();
+	void addCone(double eta,double phi);
+	void setBending(double magneticFieldZ,double maxRadius);
+
+	bool accepts(const math::XYZTLorentzVector & momentum,double charge) const;
+
+    private:
+	struct Cone
+	{
+	    double eta;
+	    double phi;
+	};
+	bool enabled_;
+	double deltaR_;
+	unsigned nConfiguredCones_;
+	std::vector<Cone> cones_;
+	// half the transverse momentum times bending angle at the edge of the tracker, per unit charge: c * 10^-4 * |B| * maxRadius / 2
+	double bendingFactor_;
+    };
+}
+
+#endif
@@ -1,6 +1,14 @@
 // system include files
 #include <memory>
 #include <string>
+#include <mutex>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include "tbb/parallel_for.h"
+#include "CLHEP/Random/RandomEngine.h"
+#include "CLHEP/Random/JamesRandom.h"
 
 // framework
 #include "FWCore/Framework/interface/Frameworkfwd.h"
@@ -12,6 +20,7 @@
 #include "FWCore/Utilities/interface/StreamID.h"
 #include "FWCore/Framework/interface/ESHandle.h"
 #include "FWCore/Framework/interface/LuminosityBlock.h"
+#include "FWCore/Framework/interface/Run.h"
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
 
 // data formats
@@ -20,64 +29,173 @@
 #include "SimDataFormats/Track/interface/SimTrackContainer.h"
 #include "SimDataFormats/Vertex/interface/SimVertexContainer.h"
 #include "DataFormats/Common/interface/Handle.h"
+#include "DataFormats/Common/interface/View.h"
+#include "DataFormats/Candidate/interface/Candidate.h"
 #include "DataFormats/Math/interface/LorentzVector.h"
+#include "SimGeneral/HepPDTRecord/interface/ParticleDataTable.h"
 
 // fastsim
 #include "FastSimulation/Utilities/interface/RandomEngineAndDistribution.h"
 #include "FastSimulation/Geometry/interface/Geometry.h"
+#include "FastSimulation/Geometry/interface/FastSimGeometryRecord.h"
 #include "FastSimulation/Layer/interface/Layer.h"
 #include "FastSimulation/Decayer/interface/Decayer.h"
 #include "FastSimulation/Propagation/interface/LayerNavigator.h"
 #include "FastSimulation/NewParticle/interface/Particle.h"
+#include "FastSimulation/NewParticle/interface/ParticleArena.h"
 #include "FastSimulation/FastSimProducer/interface/ParticleFilter.h"
-#include "FastSimulation/Particle/interface/ParticleTable.h"  // TODO: get rid of this
+#include "FastSimulation/FastSimProducer/interface/ParticlePropertyTable.h"
+#include "FastSimulation/FastSimProducer/interface/RegionOfInterest.h"
 #include "FastSimulation/InteractionModel/interface/InteractionModel.h"
 #include "FastSimulation/InteractionModel/interface/InteractionModelFactory.h"
 #include "FastSimulation/FastSimProducer/interface/ParticleLooper.h"
+#include "FastSimulation/FastSimProducer/interface/Instrumentation.h"
 
 // other
 
-class FastSimProducer : public edm::stream::EDProducer<> {
+// job-wide state, shared by all streams
+struct FastSimProducerGlobalCache
+{
+    FastSimProducerGlobalCache(const edm::ParameterSet & cfg);
+    const bool instrument;
+    const std::string instrumentationFile;
+    const std::vector<std::string> interactionModelNames;
+    // sum of the instrumentation of all streams, filled at endStream
+    mutable std::mutex mutex;
+    mutable fastsim::Instrumentation instrumentation;
+};
+
+FastSimProducerGlobalCache::FastSimProducerGlobalCache(const edm::ParameterSet & cfg)
+    : instrument(cfg.getUntrackedParameter<bool>("instrument",false))
+    , instrumentationFile(cfg.getUntrackedParameter<std::string>("instrumentationFile",""))
+    , interactionModelNames(cfg.getParameter<edm::ParameterSet>("interactionModels").getParameterNames())
+    , instrumentation(instrument,interactionModelNames)
+{;}
+
+// concurrent transport: what a task needs of its own, kept across the events of the stream
+struct TransportTask
+{
+    CLHEP::HepJamesRandom engine;
+    // same configuration (and order) as the interaction models of the stream
+    std::vector<std::unique_ptr<fastsim::InteractionModel> > interactionModels;
+    std::unique_ptr<fastsim::LayerNavigator> layerNavigators[fastsim::InteractionModel::NPARTICLECLASSES];
+    unsigned long long geometryCacheIdentifier = 0;
+    std::unique_ptr<fastsim::ParticleLooper> particleLooper;
+    std::vector<std::unique_ptr<fastsim::Particle> > secondaries;
+    fastsim::ParticleArena particleArena;
+};
+
+class FastSimProducer : public edm::stream::EDProducer<edm::GlobalCache<FastSimProducerGlobalCache> > {
 public:
 
-    explicit FastSimProducer(const edm::ParameterSet&);
+    explicit FastSimProducer(const edm::ParameterSet&,const FastSimProducerGlobalCache*);
     ~FastSimProducer(){;}
 
+    static std::unique_ptr<FastSimProducerGlobalCache> initializeGlobalCache(const edm::ParameterSet & cfg);
+    static void globalEndJob(const FastSimProducerGlobalCache * globalCache);
+
 private:
 
+    virtual void beginRun(const edm::Run&, const edm::EventSetup&) override;
     virtual void produce(edm::Event&, const edm::EventSetup&) override;
+    virtual void endStream() override;
+    void createInteractionModels(std::vector<std::unique_ptr<fastsim::InteractionModel> > & interactionModels) const;
+    void bindInteractionModels(const fastsim::Geometry & geometry);
+    void makeLayerNavigators(const fastsim::Geometry & geometry,std::unique_ptr<fastsim::LayerNavigator> (& layerNavigators)[fastsim::InteractionModel::NPARTICLECLASSES]) const;
+    // transports the particles of a looper (the whole event, or the gen particles of a task) through the layers
+    void transport(fastsim::ParticleLooper & particleLooper,
+		   std::vector<std::unique_ptr<fastsim::InteractionModel> > & interactionModels,
+		   std::unique_ptr<fastsim::LayerNavigator> (& layerNavigators)[fastsim::InteractionModel::NPARTICLECLASSES],
+		   std::vector<std::unique_ptr<fastsim::Particle> > & secondaries,
+		   CLHEP::HepRandomEngine & engine);
+    // splits the gen particles of the looper in tasks, runs them with TBB, and merges their output into the looper and the interaction models
+    void transportConcurrently(fastsim::ParticleLooper & particleLooper,CLHEP::HepRandomEngine & engine,const fastsim::Geometry & geometry);
+    // indices (in interactionModels_) of the interaction models of a layer that can act on particles of a given class
+    const std::vector<unsigned> & interactionModelIndices(const fastsim::Layer & layer,fastsim::InteractionModel::ParticleClass particleClass) const
+    {
+	return layer.isForward() ? forwardLayerInteractionModels_[particleClass][layer.index()] : barrelLayerInteractionModels_[particleClass][layer.index()];
+    }
 
     edm::EDGetTokenT<edm::HepMCProduct> genParticlesToken_;
-    fastsim::Geometry geometry_;
+    const std::string geometryLabel_;
+    unsigned long long geometryCacheIdentifier_;
     double beamPipeRadius_;
     fastsim::ParticleFilter particleFilter_;
+    // region of interest mode: only particles that can reach one of the cones are transported
+    fastsim::RegionOfInterest regionOfInterest_;
+    // seeds of the per-event cones of the region of interest (if any)
+    edm::EDGetTokenT<edm::View<reco::Candidate> > regionOfInterestSeedsToken_;
+    // order in which secondaries are simulated
+    const fastsim::ParticleLooper::SchedulingPolicy schedulingPolicy_;
     fastsim::Decayer decayer_;
+    std::mutex decayerMutex_;
+    fastsim::ParticlePropertyTable particlePropertyTable_;
+    const edm::ParameterSet interactionModelCfgs_;
     std::vector<std::unique_ptr<fastsim::InteractionModel> > interactionModels_;
-    std::map<std::string,fastsim::InteractionModel *> interactionModelMap_;
-    edm::IOVSyncValue iovSyncValue_;
+    std::map<std::string,unsigned> interactionModelMap_;
+    // dispatch tables: for each particle class and each layer of the (shared) geometry,
+    // the interaction models of this stream that can act on the particle (see InteractionModel::canAct)
+    std::vector<std::vector<unsigned> > barrelLayerInteractionModels_[fastsim::InteractionModel::NPARTICLECLASSES];
+    std::vector<std::vector<unsigned> > forwardLayerInteractionModels_[fastsim::InteractionModel::NPARTICLECLASSES];
+    // for each particle class: layers with a non-empty dispatch table (see LayerNavigator)
+    std::vector<bool> barrelLayerIsRelevant_[fastsim::InteractionModel::NPARTICLECLASSES];
+    std::vector<bool> forwardLayerIsRelevant_[fastsim::InteractionModel::NPARTICLECLASSES];
+    // for each particle class: navigator that skips the irrelevant layers, reused for all particles
+    std::unique_ptr<fastsim::LayerNavigator> layerNavigators_[fastsim::InteractionModel::NPARTICLECLASSES];
+    double maxLooperTurns_;
+    fastsim::Instrumentation instrumentation_;
+    // the secondaries of interactions and decays, a scratch buffer reused throughout the job
+    std::vector<std::unique_ptr<fastsim::Particle> > secondaries_;
+    // concurrent transport: the gen particles are transported in tasks of genParticlesPerTask_ gen particles (with their secondaries)
+    const bool concurrentTransport_;
+    const unsigned genParticlesPerTask_;
+    std::vector<std::unique_ptr<TransportTask> > transportTasks_;
+    static const double maxTaskSeed;
+    // memory of the particles of the events of this stream, reset at the end of each event
+    fastsim::ParticleArena particleArena_;
     static const std::string MESSAGECATEGORY;
 };
 
 const std::string FastSimProducer::MESSAGECATEGORY = "FastSimulation";
+// seeds of CLHEP::HepJamesRandom are in [0,900000000]
+const double FastSimProducer::maxTaskSeed = 900000000.;
 
-FastSimProducer::FastSimProducer(const edm::ParameterSet& iConfig)
+FastSimProducer::FastSimProducer(const edm::ParameterSet& iConfig,const FastSimProducerGlobalCache * globalCache)
     : genParticlesToken_(consumes<edm::HepMCProduct>(iConfig.getParameter<edm::InputTag>("src"))) 
-    , geometry_(iConfig.getParameter<edm::ParameterSet>("detectorDefinition"))
+    , geometryLabel_(iConfig.getUntrackedParameter<std::string>("geometryLabel",""))
+    , geometryCacheIdentifier_(0)
     , beamPipeRadius_(iConfig.getParameter<double>("beamPipeRadius"))
     , particleFilter_(iConfig.getParameter<edm::ParameterSet>("particleFilter"))
+    , regionOfInterest_(iConfig.getParameter<edm::ParameterSet>("regionOfInterest"))
+    , schedulingPolicy_(fastsim::ParticleLooper::schedulingPolicy(iConfig.getUntrackedParameter<std::string>("schedulingPolicy","depthFirst")))
+    , interactionModelCfgs_(iConfig.getParameter<edm::ParameterSet>("interactionModels"))
+    , maxLooperTurns_(iConfig.getUntrackedParameter<double>("maxLooperTurns",-1.))
+    , instrumentation_(globalCache->instrument,globalCache->interactionModelNames)
+    , concurrentTransport_(iConfig.getUntrackedParameter<bool>("concurrentTransport",false))
+    , genParticlesPerTask_(iConfig.getUntrackedParameter<unsigned>("genParticlesPerTask",50))
 {
+    if(concurrentTransport_ && instrumentation_.enabled())
+    {
+		throw cms::Exception("FastSimProducer") << "instrument and concurrentTransport cannot be used together";
+    }
+    if(genParticlesPerTask_ == 0)
+    {
+		throw cms::Exception("FastSimProducer") << "genParticlesPerTask must be positive";
+    }
+
+    const edm::InputTag regionOfInterestSeeds = iConfig.getParameter<edm::ParameterSet>("regionOfInterest").getParameter<edm::InputTag>("seeds");
+    if(regionOfInterest_.enabled() && !regionOfInterestSeeds.label().empty())
+    {
+		regionOfInterestSeedsToken_ = consumes<edm::View<reco::Candidate> >(regionOfInterestSeeds);
+    }
 
     //----------------
     // define interaction models
     //---------------
-    const edm::ParameterSet & modelCfgs = iConfig.getParameter<edm::ParameterSet>("interactionModels");
-    for( const std::string & modelName : modelCfgs.getParameterNames())
+    createInteractionModels(interactionModels_);
+    for(unsigned index = 0;index < interactionModels_.size();++index)
     {
-		const edm::ParameterSet & modelCfg = modelCfgs.getParameter<edm::ParameterSet>(modelName);
-		std::string modelClassName(modelCfg.getParameter<std::string>("className"));
-		std::unique_ptr<fastsim::InteractionModel> interactionModel(fastsim::InteractionModelFactory::get()->create(modelClassName,modelName,modelCfg));
-		interactionModels_.push_back(std::move(interactionModel));
-		interactionModelMap_[modelName] = interactionModels_.back().get();
+		interactionModelMap_[interactionModels_[index]->getName()] = index;
     }
 
     //----------------
@@ -92,55 +210,126 @@ FastSimProducer::FastSimProducer(const edm::ParameterSet& iConfig)
 }
 
 
+void
+FastSimProducer::beginRun(const edm::Run& iRun, const edm::EventSetup& iSetup)
+{
+    // copy the particle properties needed during the simulation into a flat table, once per run
+    edm::ESHandle < HepPDT::ParticleDataTable > pdt;
+    iSetup.getData(pdt);
+    particlePropertyTable_.update(*pdt);
+}
+
 void
 FastSimProducer::produce(edm::Event& iEvent, const edm::EventSetup& iSetup)
 {
     LogDebug(MESSAGECATEGORY) << "   produce";
 
-    // do the iov thing
-    // TODO: check me
-    if(iovSyncValue_!=iSetup.iovSyncValue())
+    // all particles of the event are created in the arena of this stream
+    // (the stream may run on a different thread in every event, but each event runs on a single thread)
+    fastsim::ParticleArena::Scope particleArenaScope(particleArena_);
+
+    // the geometry is built once per IOV by the FastSimGeometryESProducer,
+    // only the binding of this stream's interaction models to the layers is done here
+    const FastSimGeometryRecord & geometryRecord = iSetup.get<FastSimGeometryRecord>();
+    edm::ESHandle<fastsim::Geometry> geometry;
+    geometryRecord.get(geometryLabel_,geometry);
+    if(geometryCacheIdentifier_ != geometryRecord.cacheIdentifier())
     {
-		LogDebug(MESSAGECATEGORY) << "   triggering update of event setup" << std::endl;
-		iovSyncValue_=iSetup.iovSyncValue();
-		geometry_.update(iSetup,interactionModelMap_);
+		LogDebug(MESSAGECATEGORY) << "   triggering update of interaction models per layer" << std::endl;
+		geometryCacheIdentifier_ = geometryRecord.cacheIdentifier();
+		bindInteractionModels(*geometry);
     }
 
     std::unique_ptr<edm::SimTrackContainer> output_simTracks(new edm::SimTrackContainer);
     std::unique_ptr<edm::SimVertexContainer> output_simVertices(new edm::SimVertexContainer);
 
-    edm::ESHandle < HepPDT::ParticleDataTable > pdt;
-    iSetup.getData(pdt);
-    // TODO: get rid of this
-    ParticleTable::Sentry ptable(&(*pdt));
-
     edm::Handle<edm::HepMCProduct> genParticles;
     iEvent.getByToken(genParticlesToken_,genParticles);
 
     // ?? is this the right place ??
     RandomEngineAndDistribution random(iEvent.streamID());
 
+    // region of interest: cones around this event's seeds,
+    // the bending margin of charged particles is computed with the field at the center of the tracker (its maximum)
+    if(regionOfInterest_.enabled())
+    {
+		regionOfInterest_.clear();
+		regionOfInterest_.setBending(geometry->getMagneticFieldZ(math::XYZTLorentzVector(0,0,0,0)),geometry->getMaxRadius());
+		if(!regionOfInterestSeedsToken_.isUninitialized())
+		{
+		    edm::Handle<edm::View<reco::Candidate> > seeds;
+		    iEvent.getByToken(regionOfInterestSeedsToken_,seeds);
+		    for(const reco::Candidate & seed : *seeds)
+		    {
+				regionOfInterest_.addCone(seed.eta(),seed.phi());
+		    }
+		}
+    }
+
     fastsim::ParticleLooper particleLooper(
 	*genParticles->GetEvent()
-	,*pdt
+	,particlePropertyTable_
 	,beamPipeRadius_
 	,particleFilter_
+	,regionOfInterest_
+	,schedulingPolicy_
 	,output_simTracks
 	,output_simVertices);
-	
-    // loop over particles
+
     LogDebug(MESSAGECATEGORY) << "################################"
 			      << "\n###############################";    
 
-    for(std::unique_ptr<fastsim::Particle> particle = particleLooper.nextParticle(random); particle != 0;particle=particleLooper.nextParticle(random)) 
+    if(concurrentTransport_)
+    {
+		transportConcurrently(particleLooper,random.theEngine(),*geometry);
+    }
+    else
+    {
+		transport(particleLooper,interactionModels_,layerNavigators_,secondaries_,random.theEngine());
+    }
+
+    // store simHits and simTracks
+    iEvent.put(particleLooper.harvestSimTracks());
+    iEvent.put(particleLooper.harvestSimVertices());
+    // store products of interaction models, i.e. simHits
+    for(auto & interactionModel : interactionModels_)
+    {
+		interactionModel->storeProducts(iEvent);
+    }
+
+    // all particles of the event are gone: their memory is reused in the next event
+    particleArena_.reset();
+}
+
+void
+FastSimProducer::transport(fastsim::ParticleLooper & particleLooper,
+			   std::vector<std::unique_ptr<fastsim::InteractionModel> > & interactionModels,
+			   std::unique_ptr<fastsim::LayerNavigator> (& layerNavigators)[fastsim::InteractionModel::NPARTICLECLASSES],
+			   std::vector<std::unique_ptr<fastsim::Particle> > & secondaries,
+			   CLHEP::HepRandomEngine & engine)
+{
+    // the secondaries of interactions and decays are collected in a scratch buffer:
+    // after each interaction or decay, they are handed to the particle looper (or destroyed if not accepted) and the buffer is cleared
+    for(std::unique_ptr<fastsim::Particle> particle = particleLooper.nextParticle(engine); particle != 0;particle=particleLooper.nextParticle(engine)) 
     {
     	LogDebug(MESSAGECATEGORY) << "\n   moving NEXT particle: " << *particle;
 
 		// move the particle through the layers
-		fastsim::LayerNavigator layerNavigator(geometry_);
+		// (skipping the layers on which none of the interaction models can act on this particle)
+		fastsim::InteractionModel::ParticleClass particleClass = fastsim::InteractionModel::particleClass(*particle);
+		fastsim::LayerNavigator & layerNavigator = *layerNavigators[particleClass];
 		const fastsim::Layer * layer = 0;
-		while(layerNavigator.moveParticleToNextLayer(*particle,layer))
+		while(true)
 		{
+		    fastsim::Instrumentation::Timer navigationTimer(instrumentation_.navigation());
+		    // the navigator stops the particle when it leaves the tracker, decays, or after the time cut
+		    if(!layerNavigator.moveParticleToNextLayer(*particle,layer))
+		    {
+			LogDebug(MESSAGECATEGORY) << "   navigation stopped, exit state: " << layerNavigator.exitState();
+			break;
+		    }
+		    navigationTimer.stop(0);
+
 		    LogDebug(MESSAGECATEGORY) << "   moved to next layer: " << *layer
 					      << "\n   new state: " << *particle;
 
@@ -148,20 +337,20 @@ FastSimProducer::produce(edm::Event& iEvent, const edm::EventSetup& iSetup)
 			//if(layer) std::cout << layer->getMagneticFieldZ(particle->position()) << std::endl;
 		    
 		    // perform interaction between layer and particle
-		    for(fastsim::InteractionModel * interactionModel : layer->getInteractionModels())
+		    fastsim::Instrumentation::Timer layerTimer(instrumentation_.layer(layer->isForward(),layer->index()));
+		    unsigned nSecondaries = 0;
+		    for(unsigned interactionModelIndex : interactionModelIndices(*layer,particleClass))
 		    {
+				fastsim::InteractionModel * interactionModel = interactionModels[interactionModelIndex].get();
 				LogDebug(MESSAGECATEGORY) << "   interact with " << *interactionModel;
-				std::vector<std::unique_ptr<fastsim::Particle> > secondaries;
-				interactionModel->interact(*particle,*layer,secondaries,random);
-				particleLooper.addSecondaries(particle->position(),particle->simTrackIndex(),secondaries);
-		    }
-
-		    // kinematic cuts
-		    // temporary: break after 100 ns
-		    if(particle->position().T() > 100)
-		    {
-				break;
+				fastsim::Instrumentation::Timer interactionTimer(instrumentation_.interactionModel(interactionModelIndex));
+				interactionModel->interact(*particle,*layer,secondaries,engine);
+				interactionTimer.stop(secondaries.size());
+				nSecondaries += secondaries.size();
+				particleLooper.addSecondaries(particle->position(),particle->simTrackIndex(),secondaries,layer);
+				secondaries.clear();
 		    }
+		    layerTimer.stop(nSecondaries);
 		    
 		    LogDebug(MESSAGECATEGORY) << "--------------------------------"
 					      << "\n-------------------------------";
@@ -172,23 +361,188 @@ FastSimProducer::produce(edm::Event& iEvent, const edm::EventSetup& iSetup)
 		if(!particle->isStable() && particle->remainingProperLifeTime() < 1E-20)
 		{
 		    LogDebug(MESSAGECATEGORY) << "Decaying particle...";
-		    std::vector<std::unique_ptr<fastsim::Particle> > secondaries;
-		    decayer_.decay(*particle,secondaries,random.theEngine());
+		    fastsim::Instrumentation::Timer decayTimer(instrumentation_.decay());
+		    {
+				// the pythia instance of the decayer is shared by the tasks of the stream, and not re-entrant
+				std::unique_lock<std::mutex> decayerLock(decayerMutex_,std::defer_lock);
+				if(concurrentTransport_)
+				{
+				    decayerLock.lock();
+				}
+				decayer_.decay(*particle,secondaries,engine);
+		    }
+		    decayTimer.stop(secondaries.size());
 		    LogDebug(MESSAGECATEGORY) << "   decay has " << secondaries.size() << " products";
 		    particleLooper.addSecondaries(particle->position(),particle->simTrackIndex(),secondaries);
+		    secondaries.clear();
 		}
 		
 		LogDebug(MESSAGECATEGORY) << "################################"
 					  << "\n###############################";
     }
+}
 
-    // store simHits and simTracks
-    iEvent.put(particleLooper.harvestSimTracks());
-    iEvent.put(particleLooper.harvestSimVertices());
-    // store products of interaction models, i.e. simHits
-    for(auto & interactionModel : interactionModels_)
+void
+FastSimProducer::transportConcurrently(fastsim::ParticleLooper & particleLooper,CLHEP::HepRandomEngine & engine,const fastsim::Geometry & geometry)
+{
+    // the tasks only depend on the event and the configuration, not on the number of threads or the order in which the tasks run:
+    // the gen particles (in their order) are split in blocks of genParticlesPerTask_,
+    // and the engines of the tasks are seeded from the engine of the stream, in task order
+    unsigned nGenParticles = particleLooper.nGenParticles();
+    unsigned nTasks = (nGenParticles + genParticlesPerTask_ - 1) / genParticlesPerTask_;
+    while(transportTasks_.size() < nTasks)
     {
-		interactionModel->storeProducts(iEvent);
+		transportTasks_.emplace_back(new TransportTask());
+		createInteractionModels(transportTasks_.back()->interactionModels);
+    }
+    for(unsigned taskIndex = 0;taskIndex < nTasks;++taskIndex)
+    {
+		TransportTask & task = *transportTasks_[taskIndex];
+		task.engine.setSeed(long(engine.flat() * maxTaskSeed),0);
+		if(task.geometryCacheIdentifier != geometryCacheIdentifier_)
+		{
+		    task.geometryCacheIdentifier = geometryCacheIdentifier_;
+		    makeLayerNavigators(geometry,task.layerNavigators);
+		}
+		unsigned begin = taskIndex * genParticlesPerTask_;
+		task.particleLooper.reset(new fastsim::ParticleLooper(particleLooper,begin,std::min(begin + genParticlesPerTask_,nGenParticles)));
+    }
+
+    tbb::parallel_for(0u,nTasks,[this](unsigned taskIndex)
+    {
+		TransportTask & task = *transportTasks_[taskIndex];
+		// the particles of the task are created in the arena of the task
+		{
+		    fastsim::ParticleArena::Scope particleArenaScope(task.particleArena);
+		    transport(*task.particleLooper,task.interactionModels,task.layerNavigators,task.secondaries,task.engine);
+		}
+		task.particleArena.reset();
+    });
+
+    // merge the output of the tasks, in task order
+    for(unsigned taskIndex = 0;taskIndex < nTasks;++taskIndex)
+    {
+		TransportTask & task = *transportTasks_[taskIndex];
+		int simTrackIndexOffset = particleLooper.appendSimTracksAndVertices(*task.particleLooper);
+		for(unsigned index = 0;index < interactionModels_.size();++index)
+		{
+		    interactionModels_[index]->appendProducts(*task.interactionModels[index],simTrackIndexOffset);
+		}
+		task.particleLooper.reset();
+    }
+}
+
+void
+FastSimProducer::endStream()
+{
+    if(!instrumentation_.enabled())
+    {
+	return;
+    }
+    std::lock_guard<std::mutex> guard(globalCache()->mutex);
+    globalCache()->instrumentation.merge(instrumentation_);
+}
+
+std::unique_ptr<FastSimProducerGlobalCache>
+FastSimProducer::initializeGlobalCache(const edm::ParameterSet & cfg)
+{
+    return std::unique_ptr<FastSimProducerGlobalCache>(new FastSimProducerGlobalCache(cfg));
+}
+
+void
+FastSimProducer::globalEndJob(const FastSimProducerGlobalCache * globalCache)
+{
+    if(!globalCache->instrument)
+    {
+	return;
+    }
+    std::ostringstream summary;
+    globalCache->instrumentation.print(summary);
+    edm::LogPrint(MESSAGECATEGORY) << summary.str();
+    if(!globalCache->instrumentationFile.empty())
+    {
+	std::ofstream file(globalCache->instrumentationFile.c_str());
+	if(!file)
+	{
+	    throw cms::Exception("FastSimProducer") << "cannot open instrumentation file '" << globalCache->instrumentationFile << "'";
+	}
+	globalCache->instrumentation.write(file);
+    }
+}
+
+void
+FastSimProducer::createInteractionModels(std::vector<std::unique_ptr<fastsim::InteractionModel> > & interactionModels) const
+{
+    for( const std::string & modelName : interactionModelCfgs_.getParameterNames())
+    {
+		const edm::ParameterSet & modelCfg = interactionModelCfgs_.getParameter<edm::ParameterSet>(modelName);
+		std::string modelClassName(modelCfg.getParameter<std::string>("className"));
+		std::unique_ptr<fastsim::InteractionModel> interactionModel(fastsim::InteractionModelFactory::get()->create(modelClassName,modelName,modelCfg));
+		interactionModels.push_back(std::move(interactionModel));
+    }
+}
+
+void
+FastSimProducer::bindInteractionModels(const fastsim::Geometry & geometry)
+{
+    std::vector<const fastsim::Layer *> layers;
+    for(const auto & layer : geometry.barrelLayers())
+    {
+		layers.push_back(layer.get());
+    }
+    for(const auto & layer : geometry.forwardLayers())
+    {
+		layers.push_back(layer.get());
+    }
+
+    for(unsigned particleClass = 0;particleClass < fastsim::InteractionModel::NPARTICLECLASSES;++particleClass)
+    {
+		barrelLayerInteractionModels_[particleClass].assign(geometry.barrelLayers().size(),std::vector<unsigned>());
+		forwardLayerInteractionModels_[particleClass].assign(geometry.forwardLayers().size(),std::vector<unsigned>());
+		barrelLayerIsRelevant_[particleClass].assign(geometry.barrelLayers().size(),false);
+		forwardLayerIsRelevant_[particleClass].assign(geometry.forwardLayers().size(),false);
+    }
+
+    for(const fastsim::Layer * layer : layers)
+    {
+		for(const std::string & label : layer->getInteractionModelLabels())
+		{
+		    std::map<std::string,unsigned>::const_iterator interactionModel = interactionModelMap_.find(label);
+		    if(interactionModel == interactionModelMap_.end())
+		    {
+				throw cms::Exception("FastSimProducer") << "unknown interaction model '" << label << "' on layer " << *layer;
+		    }
+		    for(unsigned particleClass = 0;particleClass < fastsim::InteractionModel::NPARTICLECLASSES;++particleClass)
+		    {
+				if(!interactionModels_[interactionModel->second]->canAct(fastsim::InteractionModel::ParticleClass(particleClass),*layer))
+				{
+				    continue;
+				}
+				if(layer->isForward())
+				{
+				    forwardLayerInteractionModels_[particleClass][layer->index()].push_back(interactionModel->second);
+				    forwardLayerIsRelevant_[particleClass][layer->index()] = true;
+				}
+				else
+				{
+				    barrelLayerInteractionModels_[particleClass][layer->index()].push_back(interactionModel->second);
+				    barrelLayerIsRelevant_[particleClass][layer->index()] = true;
+				}
+		    }
+		}
+    }
+
+    makeLayerNavigators(geometry,layerNavigators_);
+}
+
+void
+FastSimProducer::makeLayerNavigators(const fastsim::Geometry & geometry,std::unique_ptr<fastsim::LayerNavigator> (& layerNavigators)[fastsim::InteractionModel::NPARTICLECLASSES]) const
+{
+    // (the dispatch tables of bindInteractionModels are shared by the tasks of the stream: the models of each task have the same configuration)
+    for(unsigned particleClass = 0;particleClass < fastsim::InteractionModel::NPARTICLECLASSES;++particleClass)
+    {
+		layerNavigators[particleClass].reset(new fastsim::LayerNavigator(geometry,barrelLayerIsRelevant_[particleClass],forwardLayerIsRelevant_[particleClass]));
+		layerNavigators[particleClass]->setMaxLooperTurns(maxLooperTurns_);
     }
 }
 
@@ -1,14 +1,35 @@
 import FWCore.ParameterSet.Config as cms
 
 from FastSimulation.Event.ParticleFilter_cfi import  ParticleFilterBlock
-from FastSimulation.Geometry.TrackerMaterial_cfi import TrackerMaterialBlock
+from FastSimulation.Geometry.GeometryESProducer_cfi import fastSimGeometry
 
 fastSimProducer = cms.EDProducer(
     "FastSimProducer",
     src = cms.InputTag("generatorSmeared"),
-    particleFilter =  ParticleFilterBlock.ParticleFilter,
-    detectorDefinition = TrackerMaterialBlock.TrackerMaterial,
+    # particles must have their origin vertex inside the volume enclosed by ECAL (vertexRMax, vertexZMax) [cm]
+    particleFilter =  ParticleFilterBlock.ParticleFilter.clone(
+        vertexRMax = cms.double(129.0),
+        vertexZMax = cms.double(317.0),
+        ),
+    geometryLabel = cms.untracked.string(""), # label of the fastsim::Geometry in the EventSetup, see fastSimGeometry
     beamPipeRadius = cms.double(3.),
+    # region of interest mode: only transport the gen particles (and their secondaries) that can reach one of the cones
+    regionOfInterest = cms.PSet(
+        enabled = cms.bool(False),
+        cones = cms.VPSet(), # fixed cones, cms.PSet(eta = cms.double(...), phi = cms.double(...))
+        seeds = cms.InputTag(""), # if not empty, one cone around each candidate of this collection (reco::Candidate)
+        deltaR = cms.double(0.5),
+        ),
+    # order in which secondaries are simulated: depthFirst, breadthFirst, energyOrdered, layerLocality
+    # the other policies change the order of the simTracks and the sequence of random numbers each particle gets:
+    # the output is not reproducible across policies (only statistically equivalent)
+    # their effect on the timing has not been measured yet, see test/benchmarkSchedulingPolicies.sh
+    schedulingPolicy = cms.untracked.string("depthFirst"),
+    maxLooperTurns = cms.untracked.double(-1.), # stop loopers that need more turns to reach the next forward layer, <= 0: no limit
+    concurrentTransport = cms.untracked.bool(False), # transport blocks of gen particles (with their secondaries) in TBB tasks, each with its own random engine; the output does not depend on the number of threads
+    genParticlesPerTask = cms.untracked.uint32(50), # size of the blocks of gen particles (concurrentTransport)
+    instrument = cms.untracked.bool(False), # time and count navigation, decays and interactions per model and per layer, summary at end of job; not together with concurrentTransport (throws)
+    instrumentationFile = cms.untracked.string(""), # if not empty, also write the instrumentation summary to this file (one counter per line)
     interactionModels = cms.PSet(
             #simpleLayerHits = cms.PSet(
             #    className = cms.string("fastsim::SimpleLayerHitProducer")
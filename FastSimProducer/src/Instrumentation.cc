@@ -0,0 +1,112 @@
+#include "FastSimulation/FastSimProducer/interface/Instrumentation.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <iomanip>
+
+fastsim::Instrumentation::Counter & fastsim::Instrumentation::Counter::operator+=(const Counter & other)
+{
+    seconds += other.seconds;
+    calls += other.calls;
+    secondaries += other.secondaries;
+    return *this;
+}
+
+fastsim::Instrumentation::Instrumentation(bool enabled,const std::vector<std::string> & interactionModelNames)
+    : enabled_(enabled)
+    , interactionModelNames_(interactionModelNames)
+    , interactionModels_(interactionModelNames.size())
+{;}
+
+void fastsim::Instrumentation::merge(const Instrumentation & other)
+{
+    if(other.interactionModelNames_ != interactionModelNames_)
+    {
+	throw cms::Exception("fastsim::Instrumentation") << "cannot merge instrumentation of different sets of interaction models";
+    }
+    navigation_ += other.navigation_;
+    decay_ += other.decay_;
+    for(unsigned index = 0;index < interactionModels_.size();++index)
+    {
+	interactionModels_[index] += other.interactionModels_[index];
+    }
+    if(barrelLayers_.size() < other.barrelLayers_.size())
+    {
+	barrelLayers_.resize(other.barrelLayers_.size());
+    }
+    for(unsigned index = 0;index < other.barrelLayers_.size();++index)
+    {
+	barrelLayers_[index] += other.barrelLayers_[index];
+    }
+    if(forwardLayers_.size() < other.forwardLayers_.size())
+    {
+	forwardLayers_.resize(other.forwardLayers_.size());
+    }
+    for(unsigned index = 0;index < other.forwardLayers_.size();++index)
+    {
+	forwardLayers_[index] += other.forwardLayers_[index];
+    }
+}
+
+namespace
+{
+    void printCounter(std::ostream & os,const std::string & name,const fastsim::Instrumentation::Counter & counter)
+    {
+	os << "\n   " << std::left << std::setw(24) << name << std::right
+	   << std::setw(14) << counter.calls
+	   << std::setw(14) << std::setprecision(4) << counter.seconds
+	   << std::setw(14) << std::setprecision(4) << (counter.calls > 0 ? counter.seconds / counter.calls * 1e9 : 0.)
+	   << std::setw(14) << counter.secondaries;
+    }
+
+    void writeCounter(std::ostream & os,const std::string & category,const std::string & name,const fastsim::Instrumentation::Counter & counter)
+    {
+	os << category << " " << name << " " << counter.calls << " " << counter.seconds << " " << counter.secondaries << "\n";
+    }
+}
+
+void fastsim::Instrumentation::print(std::ostream & os) const
+{
+    os << "fastsim::Instrumentation"
+       << "\n   " << std::left << std::setw(24) << "" << std::right
+       << std::setw(14) << "calls"
+       << std::setw(14) << "time [s]"
+       << std::setw(14) << "ns/call"
+       << std::setw(14) << "secondaries"
+       << "\n## steps";
+    printCounter(os,"navigation",navigation_);
+    printCounter(os,"decay",decay_);
+    os << "\n## interaction models";
+    for(unsigned index = 0;index < interactionModels_.size();++index)
+    {
+	printCounter(os,interactionModelNames_[index],interactionModels_[index]);
+    }
+    os << "\n## barrel layers (interactions)";
+    for(unsigned index = 0;index < barrelLayers_.size();++index)
+    {
+	printCounter(os,"barrel layer " + std::to_string(index),barrelLayers_[index]);
+    }
+    os << "\n## forward layers (interactions)";
+    for(unsigned index = 0;index < forwardLayers_.size();++index)
+    {
+	printCounter(os,"forward layer " + std::to_string(index),forwardLayers_[index]);
+    }
+}
+
+void fastsim::Instrumentation::write(std::ostream & os) const
+{
+    os << "# category name calls seconds secondaries\n";
+    writeCounter(os,"step","navigation",navigation_);
+    writeCounter(os,"step","decay",decay_);
+    for(unsigned index = 0;index < interactionModels_.size();++index)
+    {
+	writeCounter(os,"interactionModel",interactionModelNames_[index],interactionModels_[index]);
+    }
+    for(unsigned index = 0;index < barrelLayers_.size();++index)
+    {
+	writeCounter(os,"barrelLayer",std::to_string(index),barrelLayers_[index]);
+    }
+    for(unsigned index = 0;index < forwardLayers_.size();++index)
+    {
+	writeCounter(os,"forwardLayer",std::to_string(index),forwardLayers_[index]);
+    }
+}
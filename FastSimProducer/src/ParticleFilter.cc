@@ -20,48 +20,49 @@ fastsim::ParticleFilter::ParticleFilter(const edm::ParameterSet & cfg)
     cos2ThetaMax_ *= cos2ThetaMax_;
 
     // Particles must have vertex inside the volume enclosed by ECAL
-    vertexRMax2_ = 129.0*129.0; 
-    vertexZMax_ = 317;
+    double vertexRMax = cfg.getParameter<double>("vertexRMax");
+    vertexRMax2_ = vertexRMax*vertexRMax;
+    vertexZMax_ = cfg.getParameter<double>("vertexZMax");
 }
 
 bool fastsim::ParticleFilter::accepts(const fastsim::Particle & particle) const
 {
-    int pId = abs(particle.pdgId());
+    return accepts(particle.pdgId(),particle.charge(),
+		   particle.position().X(),particle.position().Y(),particle.position().Z(),
+		   particle.momentum().Px(),particle.momentum().Py(),particle.momentum().Pz(),particle.momentum().E());
+}
 
-    // skip invisible particles
-    if(pId == 12 || pId == 14 || pId == 16 || pId == 1000022)
-    {
-	return false;
-    }
-    
-    // keep all high-energy protons
-    else if(pId == 2212 && particle.momentum().E() >= protonEMin_)
-    {
-	return true;
-    }
-    
-    // cut on the energy
-    else if( particle.momentum().E() < EMin_)
+void fastsim::ParticleFilter::accepts(const Particles & particles,std::vector<unsigned char> & accept) const
+{
+    accept.resize(particles.size);
+    if(particles.charge)
     {
-	return false;
+	for(unsigned index = 0;index < particles.size;++index)
+	{
+	    accept[index] = accepts(particles.pdgId[index],particles.charge[index],
+				    particles.x[index],particles.y[index],particles.z[index],
+				    particles.px[index],particles.py[index],particles.pz[index],particles.e[index]);
+	}
     }
-    
-    // cut on pt of charged particles
-    else if( particle.charge()!=0 && particle.momentum().Perp2()<chargedPtMin2_)
+    else
     {
-	return false;
+	for(unsigned index = 0;index < particles.size;++index)
+	{
+	    accept[index] = accepts(particles.pdgId[index],fastsim::Particle::unsetCharge,
+				    particles.x[index],particles.y[index],particles.z[index],
+				    particles.px[index],particles.py[index],particles.pz[index],particles.e[index]);
+	}
     }
-    
-    // cut on eta if the origin vertex is close to the beam
-    else if( particle.position().Perp2() < 25. && particle.momentum().Pz()*particle.momentum().Pz()/particle.momentum().P2() > cos2ThetaMax_)
+}
+
+void fastsim::ParticleFilter::accepts(const std::vector<std::unique_ptr<fastsim::Particle> > & particles,std::vector<unsigned char> & accept) const
+{
+    accept.resize(particles.size());
+    for(unsigned index = 0;index < particles.size();++index)
     {
-	return false;
+	accept[index] = accepts(*particles[index]);
     }
-
-    // particles must have vertex in volume enclosed by ECAL
-    return accepts(particle.position());
-} 
-
+}
 
 bool fastsim::ParticleFilter::accepts(const math::XYZTLorentzVector & originVertex) const
 {
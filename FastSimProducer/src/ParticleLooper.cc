@@ -2,33 +2,38 @@
 
 #include "HepMC/GenEvent.h"
 #include "HepMC/Units.h"
-#include "HepPDT/ParticleDataTable.hh"
 
 #include "FastSimulation/NewParticle/interface/Particle.h"
 #include "FastSimulation/FastSimProducer/interface/ParticleFilter.h"
+#include "FastSimulation/FastSimProducer/interface/ParticlePropertyTable.h"
+#include "FastSimulation/FastSimProducer/interface/RegionOfInterest.h"
 #include "FastSimulation/Constants/interface/Constants.h"
 
 #include "SimDataFormats/Track/interface/SimTrack.h"
 #include "SimDataFormats/Vertex/interface/SimVertex.h"
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
-#include "FastSimulation/Utilities/interface/RandomEngineAndDistribution.h"
+#include "CLHEP/Random/RandomEngine.h"
+
+#include <algorithm>
 
 fastsim::ParticleLooper::ParticleLooper(
     const HepMC::GenEvent & genEvent,
-    const HepPDT::ParticleDataTable & particleDataTable,
+    const ParticlePropertyTable & particlePropertyTable,
     double beamPipeRadius,
     const fastsim::ParticleFilter & particleFilter,
+    const fastsim::RegionOfInterest & regionOfInterest,
+    SchedulingPolicy schedulingPolicy,
     std::unique_ptr<std::vector<SimTrack> > & simTracks,
     std::unique_ptr<std::vector<SimVertex> > & simVertices)
     : genEvent_(&genEvent)
-    , genParticleIterator_(genEvent_->particles_begin())
-    , genParticleEnd_(genEvent_->particles_end())
-    , genParticleIndex_(1)
-    , particleDataTable_(&particleDataTable)
+    , nextGenParticle_(0)
+    , particlePropertyTable_(&particlePropertyTable)
     , beamPipeRadius2_(beamPipeRadius*beamPipeRadius)
     , particleFilter_(&particleFilter)
+    , regionOfInterest_(&regionOfInterest)
     , simTracks_(std::move(simTracks))
     , simVertices_(std::move(simVertices))
+    , nSharedSimVertices_(0)
     // prepare unit convsersions
     //  --------------------------------------------
     // |          |      hepmc               |  cms |
@@ -41,6 +46,8 @@ fastsim::ParticleLooper::ParticleLooper(
     , lengthUnitConversionFactor_(conversion_factor(genEvent_->length_unit(),HepMC::Units::LengthUnit::CM))
     , lengthUnitConversionFactor2_(lengthUnitConversionFactor_*lengthUnitConversionFactor_)
     , timeUnitConversionFactor_(lengthUnitConversionFactor_/29.9792458) // speed of light [cm / ns]
+    , schedulingPolicy_(schedulingPolicy)
+    , currentLayer_(0)
 {
     // add the main vertex from the signal event to the simvertex collection
     if(genEvent.vertices_begin() != genEvent_->vertices_end())
@@ -52,37 +59,159 @@ fastsim::ParticleLooper::ParticleLooper(
 					     position.t()*timeUnitConversionFactor_)
 		     ,-1);
     }
+
+    // convert the gen particles once, and select the ones to simulate in one pass
+    readGenParticles(genEvent);
+    selectGenParticles();
+}
+
+fastsim::ParticleLooper::ParticleLooper(const ParticleLooper & eventLooper,unsigned begin,unsigned end)
+    : genEvent_(eventLooper.genEvent_)
+    , nextGenParticle_(0)
+    , particlePropertyTable_(eventLooper.particlePropertyTable_)
+    , beamPipeRadius2_(eventLooper.beamPipeRadius2_)
+    , particleFilter_(eventLooper.particleFilter_)
+    , regionOfInterest_(eventLooper.regionOfInterest_)
+    , simTracks_(new std::vector<SimTrack>())
+    , simVertices_(new std::vector<SimVertex>())
+    , momentumUnitConversionFactor_(eventLooper.momentumUnitConversionFactor_)
+    , lengthUnitConversionFactor_(eventLooper.lengthUnitConversionFactor_)
+    , lengthUnitConversionFactor2_(eventLooper.lengthUnitConversionFactor2_)
+    , timeUnitConversionFactor_(eventLooper.timeUnitConversionFactor_)
+    , schedulingPolicy_(eventLooper.schedulingPolicy_)
+    , currentLayer_(0)
+{
+    // the gen particles point to the main vertex (see nextGenParticle)
+    if(!eventLooper.simVertices_->empty())
+    {
+	simVertices_->push_back(eventLooper.simVertices_->front());
+	nSharedSimVertices_ = 1;
+    }
+    genParticles_.assign(eventLooper.genParticles_,begin,end);
 }
 
 fastsim::ParticleLooper::~ParticleLooper(){}
 
-std::unique_ptr<fastsim::Particle> fastsim::ParticleLooper::nextParticle(const RandomEngineAndDistribution & random)
+int fastsim::ParticleLooper::appendSimTracksAndVertices(ParticleLooper & taskLooper)
+{
+    // the shared vertices keep their index, the other indices are shifted
+    int simTrackIndexOffset = simTracks_->size();
+    int simVertexIndexOffset = int(simVertices_->size()) - int(taskLooper.nSharedSimVertices_);
+    for(unsigned index = taskLooper.nSharedSimVertices_;index < taskLooper.simVertices_->size();++index)
+    {
+	const SimVertex & simVertex = (*taskLooper.simVertices_)[index];
+	simVertices_->emplace_back(simVertex.position().Vect(),
+				   simVertex.position().T(),
+				   simVertex.noParent() ? -1 : simVertex.parentIndex() + simTrackIndexOffset,
+				   index + simVertexIndexOffset);
+    }
+    for(const SimTrack & simTrack : *taskLooper.simTracks_)
+    {
+	int simVertexIndex = simTrack.vertIndex() >= int(taskLooper.nSharedSimVertices_) ? simTrack.vertIndex() + simVertexIndexOffset : simTrack.vertIndex();
+	simTracks_->emplace_back(simTrack.type(),simTrack.momentum(),simVertexIndex,simTrack.genpartIndex());
+	simTracks_->back().setTrackId(simTrack.trackId() + simTrackIndexOffset);
+    }
+    taskLooper.simTracks_->clear();
+    taskLooper.simVertices_->erase(taskLooper.simVertices_->begin() + taskLooper.nSharedSimVertices_,taskLooper.simVertices_->end());
+    return simTrackIndexOffset;
+}
+
+fastsim::ParticleLooper::SchedulingPolicy fastsim::ParticleLooper::schedulingPolicy(const std::string & name)
+{
+    if(name == "depthFirst")
+    {
+	return DEPTHFIRST;
+    }
+    else if(name == "breadthFirst")
+    {
+	return BREADTHFIRST;
+    }
+    else if(name == "energyOrdered")
+    {
+	return ENERGYORDERED;
+    }
+    else if(name == "layerLocality")
+    {
+	return LAYERLOCALITY;
+    }
+    throw cms::Exception("fastsim::ParticleLooper") << "unknown scheduling policy '" << name << "' (depthFirst, breadthFirst, energyOrdered, layerLocality)";
+}
+
+namespace
+{
+    // ENERGYORDERED: the buffer is a max-heap on the energy
+    struct LowerEnergy
+    {
+	template<class Entry>
+	bool operator()(const Entry & a,const Entry & b) const
+	{
+	    return a.particle->momentum().E() < b.particle->momentum().E();
+	}
+    };
+}
+
+std::unique_ptr<fastsim::Particle> fastsim::ParticleLooper::nextBufferedParticle()
+{
+    std::unique_ptr<Particle> particle;
+    switch(schedulingPolicy_)
+    {
+    case BREADTHFIRST:
+	particle = std::move(particleBuffer_.front().particle);
+	particleBuffer_.pop_front();
+	break;
+    case ENERGYORDERED:
+	std::pop_heap(particleBuffer_.begin(),particleBuffer_.end(),LowerEnergy());
+	particle = std::move(particleBuffer_.back().particle);
+	particleBuffer_.pop_back();
+	break;
+    case LAYERLOCALITY:
+    {
+	// the latest secondary produced on the current layer, or else the latest secondary,
+	// which is also the latest of its own layer
+	std::unordered_map<const Layer *,std::vector<unsigned> >::iterator bucket = layerBuckets_.find(currentLayer_);
+	if(bucket == layerBuckets_.end() || bucket->second.empty())
+	{
+	    bucket = layerBuckets_.find(particleBuffer_.back().layer);
+	}
+	BufferEntry & entry = particleBuffer_[bucket->second.back()];
+	bucket->second.pop_back();
+	particle = std::move(entry.particle);
+	currentLayer_ = entry.layer;
+	// the last entry of the buffer is never empty: the buffer is empty when all secondaries are handed out
+	while(!particleBuffer_.empty() && !particleBuffer_.back().particle)
+	{
+	    particleBuffer_.pop_back();
+	}
+	break;
+    }
+    default:
+	particle = std::move(particleBuffer_.back().particle);
+	particleBuffer_.pop_back();
+    }
+    return particle;
+}
+
+std::unique_ptr<fastsim::Particle> fastsim::ParticleLooper::nextParticle(CLHEP::HepRandomEngine & random)
 {
     std::unique_ptr<fastsim::Particle> particle;
 
-    // retrieve particle from buffer
+    // retrieve particle from buffer (filtered in addSecondaries)
     if(particleBuffer_.size() > 0)
     {
-    	particle = std::move(particleBuffer_.back());
-    	particleBuffer_.pop_back();
+	particle = nextBufferedParticle();
     }
-    // or from genParticle list
+    // or from genParticle list (filtered in selectGenParticles)
     else
     {
-	   particle = nextGenParticle();
-       if(!particle) return 0;
+	particle = nextGenParticle();
+	if(!particle) return 0;
     }
 
-    // if filter does not accept, skip particle
-    if(!particleFilter_->accepts(*particle))
-    {
-	   return nextParticle(random);
-    }
     if(!particle->remainingProperLifeTimeIsSet() || !particle->chargeIsSet() )
     {
     	// retrieve the particle data
-    	const HepPDT::ParticleData * particleData = particleDataTable_->particle(HepPDT::ParticleID(particle->pdgId()));
-    	if(!particleData)
+    	const ParticlePropertyTable::Properties * properties = particlePropertyTable_->properties(particle->pdgId());
+    	if(!properties)
     	{
     	    throw cms::Exception("fastsim::ParticleLooper") << "unknown pdg id" << std::endl;
     	}
@@ -90,21 +219,20 @@ std::unique_ptr<fastsim::Particle> fastsim::ParticleLooper::nextParticle(const R
     	// set lifetime
     	if(!particle->remainingProperLifeTimeIsSet())
     	{
-    	    double averageLifeTime = particleData->lifetime().value()/fastsim::Constants::speedOfLight; //!!! units: particleData returns units in c*t?
-    	    if(averageLifeTime > 1e25 || averageLifeTime < 1e-25) // ridiculously safe // particleData seems to return 0 in case particle is stable!
+    	    if(properties->stable)
     	    {
     		  particle->setStable();
     	    }
     	    else
     	    {
-    		  particle->setRemainingProperLifeTime(-log(random.flatShoot())*averageLifeTime);
+    		  particle->setRemainingProperLifeTime(-log(random.flat())*properties->averageLifeTime);
     	    }
     	}
 
     	// set charge
     	if(!particle->chargeIsSet())
     	{
-    	    particle->setCharge(particleData->charge());
+    	    particle->setCharge(properties->charge);
     	}
     }
 
@@ -125,7 +253,8 @@ std::unique_ptr<fastsim::Particle> fastsim::ParticleLooper::nextParticle(const R
 void fastsim::ParticleLooper::addSecondaries(
     const math::XYZTLorentzVector & vertexPosition,
     int parentSimTrackIndex,
-    std::vector<std::unique_ptr<Particle> > & secondaries)
+    std::vector<std::unique_ptr<Particle> > & secondaries,
+    const fastsim::Layer * layer)
 {
 
     // vertex must be within the accepted volume
@@ -142,11 +271,23 @@ void fastsim::ParticleLooper::addSecondaries(
     // add simVertex
     unsigned simVertexIndex = addSimVertex(vertexPosition,parentSimTrackIndex);
 
-    // add secondaries to buffer
-    for(auto & secondary : secondaries)
+    // add the secondaries accepted by the filter to buffer
+    particleFilter_->accepts(secondaries,accept_);
+    for(unsigned index = 0;index < secondaries.size();++index)
     {
-	secondary->setSimVertexIndex(simVertexIndex);
-	particleBuffer_.push_back(std::move(secondary));
+	if(accept_[index])
+	{
+	    secondaries[index]->setSimVertexIndex(simVertexIndex);
+	    particleBuffer_.push_back(BufferEntry{std::move(secondaries[index]),layer});
+	    if(schedulingPolicy_ == ENERGYORDERED)
+	    {
+		std::push_heap(particleBuffer_.begin(),particleBuffer_.end(),LowerEnergy());
+	    }
+	    else if(schedulingPolicy_ == LAYERLOCALITY)
+	    {
+		layerBuckets_[layer].push_back(particleBuffer_.size() - 1);
+	    }
+	}
     }
 
 }
@@ -174,65 +315,149 @@ unsigned fastsim::ParticleLooper::addSimTrack(const fastsim::Particle * particle
     return simTrackIndex;
 }
 
+void fastsim::ParticleLooper::GenParticles::resize(unsigned size)
+{
+    pdgId.resize(size);
+    genParticleIndex.resize(size);
+    x.resize(size);
+    y.resize(size);
+    z.resize(size);
+    t.resize(size);
+    px.resize(size);
+    py.resize(size);
+    pz.resize(size);
+    e.resize(size);
+    labFrameLifeTime.resize(size);
+    endVertexR2.resize(size);
+}
+
+void fastsim::ParticleLooper::GenParticles::assign(const GenParticles & other,unsigned begin,unsigned end)
+{
+    pdgId.assign(other.pdgId.begin() + begin,other.pdgId.begin() + end);
+    genParticleIndex.assign(other.genParticleIndex.begin() + begin,other.genParticleIndex.begin() + end);
+    x.assign(other.x.begin() + begin,other.x.begin() + end);
+    y.assign(other.y.begin() + begin,other.y.begin() + end);
+    z.assign(other.z.begin() + begin,other.z.begin() + end);
+    t.assign(other.t.begin() + begin,other.t.begin() + end);
+    px.assign(other.px.begin() + begin,other.px.begin() + end);
+    py.assign(other.py.begin() + begin,other.py.begin() + end);
+    pz.assign(other.pz.begin() + begin,other.pz.begin() + end);
+    e.assign(other.e.begin() + begin,other.e.begin() + end);
+    labFrameLifeTime.assign(other.labFrameLifeTime.begin() + begin,other.labFrameLifeTime.begin() + end);
+    endVertexR2.assign(other.endVertexR2.begin() + begin,other.endVertexR2.begin() + end);
+}
+
+void fastsim::ParticleLooper::readGenParticles(const HepMC::GenEvent & genEvent)
+{
+    // the only pass over the HepMC particles: copy (with unit conversion) what is needed to select and create the particles
+    genParticles_.resize(genEvent.particles_size());
+    unsigned size = 0;
+    int genParticleIndex = 1;
+    for(HepMC::GenEvent::particle_const_iterator genParticle = genEvent.particles_begin();genParticle != genEvent.particles_end();++genParticle,++genParticleIndex)
+    {
+	const HepMC::GenParticle & particle = **genParticle;
+	const HepMC::GenVertex * productionVertex = particle.production_vertex();
+	const HepMC::GenVertex * endVertex = particle.end_vertex();
+
+	// skip incoming particles
+	if(!productionVertex)
+	{
+	    continue;
+	}
+
+	genParticles_.pdgId[size] = particle.pdg_id();
+	genParticles_.genParticleIndex[size] = genParticleIndex;
+	genParticles_.x[size] = productionVertex->position().x()*lengthUnitConversionFactor_;
+	genParticles_.y[size] = productionVertex->position().y()*lengthUnitConversionFactor_;
+	genParticles_.z[size] = productionVertex->position().z()*lengthUnitConversionFactor_;
+	genParticles_.t[size] = productionVertex->position().t()*timeUnitConversionFactor_;
+	genParticles_.px[size] = particle.momentum().x()*momentumUnitConversionFactor_;
+	genParticles_.py[size] = particle.momentum().y()*momentumUnitConversionFactor_;
+	genParticles_.pz[size] = particle.momentum().z()*momentumUnitConversionFactor_;
+	genParticles_.e[size] = particle.momentum().e()*momentumUnitConversionFactor_;
+	// try to get the life time of the particle from the genEvent
+	genParticles_.labFrameLifeTime[size] = endVertex ? (endVertex->position().t() - productionVertex->position().t())*timeUnitConversionFactor_ : 0;
+	genParticles_.endVertexR2[size] = endVertex ? endVertex->position().perp2()*lengthUnitConversionFactor2_ : -1;
+	++size;
+    }
+    genParticles_.resize(size);
+}
+
+void fastsim::ParticleLooper::selectGenParticles()
+{
+    // keep (in place, in the original order) the particles that
+    // - are produced within the beam pipe
+    // - do not decay before they reach the beam pipe
+    // - can reach the region of interest, if any
+    // - are accepted by the particle filter
+    //   (as before, gen particles are filtered before their charge is set: the charged particle p_T cut applies to all of them)
+    ParticleFilter::Particles particles{genParticles_.size(),genParticles_.pdgId.data(),0,
+	    genParticles_.x.data(),genParticles_.y.data(),genParticles_.z.data(),
+	    genParticles_.px.data(),genParticles_.py.data(),genParticles_.pz.data(),genParticles_.e.data()};
+    particleFilter_->accepts(particles,accept_);
+
+    unsigned size = 0;
+    for(unsigned index = 0;index < genParticles_.size();++index)
+    {
+	int pdgId = genParticles_.pdgId[index];
+
+	bool accept = accept_[index]
+	    && genParticles_.x[index]*genParticles_.x[index] + genParticles_.y[index]*genParticles_.y[index] <= beamPipeRadius2_
+	    && (genParticles_.endVertexR2[index] < 0 || genParticles_.endVertexR2[index] >= beamPipeRadius2_);
+	if(accept && regionOfInterest_->enabled())
+	{
+	    const ParticlePropertyTable::Properties * properties = particlePropertyTable_->properties(pdgId);
+	    math::XYZTLorentzVector momentum(genParticles_.px[index],genParticles_.py[index],genParticles_.pz[index],genParticles_.e[index]);
+	    accept = !properties || regionOfInterest_->accepts(momentum,properties->charge);
+	}
+	if(!accept)
+	{
+	    continue;
+	}
+
+	genParticles_.pdgId[size] = pdgId;
+	genParticles_.genParticleIndex[size] = genParticles_.genParticleIndex[index];
+	genParticles_.x[size] = genParticles_.x[index];
+	genParticles_.y[size] = genParticles_.y[index];
+	genParticles_.z[size] = genParticles_.z[index];
+	genParticles_.t[size] = genParticles_.t[index];
+	genParticles_.px[size] = genParticles_.px[index];
+	genParticles_.py[size] = genParticles_.py[index];
+	genParticles_.pz[size] = genParticles_.pz[index];
+	genParticles_.e[size] = genParticles_.e[index];
+	genParticles_.labFrameLifeTime[size] = genParticles_.labFrameLifeTime[index];
+	genParticles_.endVertexR2[size] = genParticles_.endVertexR2[index];
+	++size;
+    }
+    genParticles_.resize(size);
+}
+
 std::unique_ptr<fastsim::Particle> fastsim::ParticleLooper::nextGenParticle()
 {
-    // only consider particles that start in the beam pipe and end outside the beam pipe
-    // try to get the decay time from pythia
-    // use hepmc units
-    // make the link simtrack to simvertex
-    // try not to change the simvertex structure
-    // print a couple of ttbar events to undertand the simtrack structure? nah...
-    
-    for ( ; genParticleIterator_ != genParticleEnd_ ; ++genParticleIterator_,++genParticleIndex_ ) // loop over gen particles
-    {
-    	// some handy pointers and references
-    	const HepMC::GenParticle & particle = **genParticleIterator_;
-    	const HepMC::GenVertex * productionVertex = particle.production_vertex();
-    	const HepMC::GenVertex * endVertex = particle.end_vertex();
-
-        // skip incoming particles
-        if(!productionVertex){
-            continue;
-        }
-
-    	// particle must be produced within the beampipe
-    	if(productionVertex->position().perp2()*lengthUnitConversionFactor2_ > beamPipeRadius2_)
-    	{
-    	    continue;
-    	}
-    	
-    	// particle must not decay before it reaches the beam pipe
-    	if(endVertex && endVertex->position().perp2()*lengthUnitConversionFactor2_ < beamPipeRadius2_)
-    	{
-    	    continue;
-    	}
-    	// make the particle
-    	std::unique_ptr<Particle> newParticle(
-    	    new Particle(particle.pdg_id(),
-    			 math::XYZTLorentzVector(productionVertex->position().x()*lengthUnitConversionFactor_,
-    						 productionVertex->position().y()*lengthUnitConversionFactor_,
-    						 productionVertex->position().z()*lengthUnitConversionFactor_,
-    						 productionVertex->position().t()*timeUnitConversionFactor_),
-    			 math::XYZTLorentzVector(particle.momentum().x()*momentumUnitConversionFactor_,
-    						 particle.momentum().y()*momentumUnitConversionFactor_,
-    						 particle.momentum().z()*momentumUnitConversionFactor_,
-    						 particle.momentum().e()*momentumUnitConversionFactor_)));
-    	newParticle->setGenParticleIndex(genParticleIndex_);
-
-    	// try to get the life time of the particle from the genEvent
-    	if(endVertex)
-    	{
-    	    double labFrameLifeTime = (endVertex->position().t() - productionVertex->position().t())*timeUnitConversionFactor_;
-    	    newParticle->setRemainingProperLifeTime(labFrameLifeTime * newParticle->gamma());
-    	}
+    if(nextGenParticle_ >= genParticles_.size())
+    {
+	return std::unique_ptr<Particle>();
+    }
+    unsigned index = nextGenParticle_++;
+
+    // the secondaries of the previous gen particle are all simulated: no layer to stay on (LAYERLOCALITY)
+    currentLayer_ = 0;
 
-        // TODO: THIS HAS TO BE FIXED! E.g. the products of a b-decay should point to that vertex and not to the primary vertex!
-        newParticle->setSimVertexIndex(0);
+    // make the particle
+    std::unique_ptr<Particle> newParticle(
+	new Particle(genParticles_.pdgId[index],
+		     math::XYZTLorentzVector(genParticles_.x[index],genParticles_.y[index],genParticles_.z[index],genParticles_.t[index]),
+		     math::XYZTLorentzVector(genParticles_.px[index],genParticles_.py[index],genParticles_.pz[index],genParticles_.e[index])));
+    newParticle->setGenParticleIndex(genParticles_.genParticleIndex[index]);
 
-        ++genParticleIterator_; ++genParticleIndex_;
-    	// and return
-    	return std::move(newParticle);
+    // life time from the genEvent, if the particle has an end vertex
+    if(genParticles_.endVertexR2[index] >= 0)
+    {
+	newParticle->setRemainingProperLifeTime(genParticles_.labFrameLifeTime[index] * newParticle->gamma());
     }
 
-    return std::unique_ptr<Particle>();
+    // TODO: THIS HAS TO BE FIXED! E.g. the products of a b-decay should point to that vertex and not to the primary vertex!
+    newParticle->setSimVertexIndex(0);
+
+    return newParticle;
 }
@@ -0,0 +1,52 @@
+#include "FastSimulation/FastSimProducer/interface/ParticlePropertyTable.h"
+#include "FastSimulation/Constants/interface/Constants.h"
+
+#include "HepPDT/ParticleDataTable.hh"
+
+#include <algorithm>
+
+fastsim::ParticlePropertyTable::ParticlePropertyTable()
+    : direct_(2 * directSize_)
+{;}
+
+void fastsim::ParticlePropertyTable::update(const HepPDT::ParticleDataTable & particleDataTable)
+{
+    direct_.assign(2 * directSize_,Properties());
+    other_.clear();
+
+    for(HepPDT::ParticleDataTable::const_iterator entry = particleDataTable.begin();entry != particleDataTable.end();++entry)
+    {
+	const HepPDT::ParticleData & particleData = entry->second;
+	Properties properties;
+	properties.known = true;
+	properties.charge = particleData.charge();
+	properties.averageLifeTime = particleData.lifetime().value()/fastsim::Constants::speedOfLight; //!!! units: particleData returns units in c*t?
+	// ridiculously safe // particleData seems to return 0 in case particle is stable!
+	properties.stable = properties.averageLifeTime > 1e25 || properties.averageLifeTime < 1e-25;
+
+	int pdgId = entry->first.pid();
+	if(std::abs(pdgId) < directSize_)
+	{
+	    direct_[pdgId + directSize_] = properties;
+	}
+	else
+	{
+	    other_.push_back(std::make_pair(pdgId,properties));
+	}
+    }
+
+    std::sort(other_.begin(),other_.end(),
+	      [](const std::pair<int,Properties> & a,const std::pair<int,Properties> & b){return a.first < b.first;});
+}
+
+const fastsim::ParticlePropertyTable::Properties * fastsim::ParticlePropertyTable::otherProperties(int pdgId) const
+{
+    std::vector<std::pair<int,Properties> >::const_iterator entry = std::lower_bound(
+	other_.begin(),other_.end(),pdgId,
+	[](const std::pair<int,Properties> & a,int b){return a.first < b;});
+    if(entry == other_.end() || entry->first != pdgId)
+    {
+	return 0;
+    }
+    return &entry->second;
+}
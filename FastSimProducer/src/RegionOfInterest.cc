@@ -0,0 +1,71 @@
+#include "FastSimulation/FastSimProducer/interface/RegionOfInterest.h"
+#include "FastSimulation/Constants/interface/Constants.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "DataFormats/Math/interface/deltaPhi.h"
+
+#include <cmath>
+
+fastsim::RegionOfInterest::RegionOfInterest(const edm::ParameterSet & cfg)
+    : enabled_(cfg.getParameter<bool>("enabled"))
+    , deltaR_(cfg.getParameter<double>("deltaR"))
+    , bendingFactor_(0)
+{
+    for(const edm::ParameterSet & coneCfg : cfg.getParameter<std::vector<edm::ParameterSet> >("cones"))
+    {
+	cones_.push_back(Cone{coneCfg.getParameter<double>("eta"),coneCfg.getParameter<double>("phi")});
+    }
+    nConfiguredCones_ = cones_.size();
+}
+
+void fastsim::RegionOfInterest::clear()
+{
+    cones_.resize(nConfiguredCones_);
+}
+
+void fastsim::RegionOfInterest::addCone(double eta,double phi)
+{
+    cones_.push_back(Cone{eta,phi});
+}
+
+void fastsim::RegionOfInterest::setBending(double magneticFieldZ,double maxRadius)
+{
+    // track radius [cm] = p_T / (c * 10^-4 * |q * B|), see HelixTrajectory
+    // a track from the beam line reaches radius r at a phi of asin(r / (2 * radius)) w.r.t. its initial direction
+    bendingFactor_ = fastsim::Constants::speedOfLight * 1e-4 * std::abs(magneticFieldZ) * maxRadius / 2.;
+}
+
+bool fastsim::RegionOfInterest::accepts(const math::XYZTLorentzVector & momentum,double charge) const
+{
+    if(!enabled_)
+    {
+	return true;
+    }
+    if(momentum.Perp2() == 0)
+    {
+	return false;
+    }
+
+    double eta = momentum.Eta();
+    double phi = momentum.Phi();
+    double sinBending = std::abs(charge) * bendingFactor_ / momentum.Pt();
+    double bending = sinBending < 1 ? std::asin(sinBending) : M_PI;
+
+    for(const Cone & cone : cones_)
+    {
+	double deltaEta = eta - cone.eta;
+	if(std::abs(deltaEta) > deltaR_)
+	{
+	    continue;
+	}
+	double deltaPhi = std::abs(reco::deltaPhi(phi,cone.phi)) - bending;
+	if(deltaPhi < 0)
+	{
+	    deltaPhi = 0;
+	}
+	if(deltaEta*deltaEta + deltaPhi*deltaPhi < deltaR_*deltaR_)
+	{
+	    return true;
+	}
+    }
+    return false;
+}
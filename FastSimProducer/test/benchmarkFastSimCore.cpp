@@ -0,0 +1,409 @@
+// microbenchmarks of the fastsim core: trajectories, navigation and particle filter
+// on the layers of TrackerMaterial_cfi.py (see Geometry/interface/SyntheticGeometry.h), without cmsRun
+// not framework independent: it runs without cmsRun, EventSetup or services,
+// but links the fastsim libraries with their dependencies (FWCore/Framework, FWCore/ParameterSet, HepPDT, ...)
+// run e.g. with --benchmark_repetitions=5 --benchmark_report_aggregates_only=true
+
+#include "FastSimulation/Geometry/interface/SyntheticGeometry.h"
+#include "FastSimulation/Layer/interface/BarrelLayer.h"
+#include "FastSimulation/Layer/interface/ForwardLayer.h"
+#include "FastSimulation/NewParticle/interface/Particle.h"
+#include "FastSimulation/Propagation/interface/LayerNavigator.h"
+#include "FastSimulation/Propagation/interface/TrajectoryVariant.h"
+#include "FastSimulation/FastSimProducer/interface/ParticleFilter.h"
+#include "FastSimulation/FastSimProducer/interface/Instrumentation.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const double magneticFieldZ = 3.8;
+    const unsigned nParticles = 10000;
+
+    const fastsim::Geometry & geometry()
+    {
+	static std::unique_ptr<fastsim::Geometry> geometry = fastsim::test::syntheticGeometry(fastsim::test::syntheticGeometryConfig(magneticFieldZ));
+	return *geometry;
+    }
+
+    // stable particles from the beam spot, with a soft, minimum-bias like spectrum:
+    // pT = 0.1 GeV + exponential with mean 0.5 GeV, |eta| < 3, flat in phi
+    // charged: pions of both charges, neutral: photons
+    std::vector<fastsim::Particle> makeParticles(bool charged,unsigned seed = 1)
+    {
+	std::mt19937 engine(seed);
+	std::exponential_distribution<double> pt(2.);
+	std::uniform_real_distribution<double> eta(-3.,3.);
+	std::uniform_real_distribution<double> phi(-M_PI,M_PI);
+	std::normal_distribution<double> vertexR(0.,0.001);
+	std::normal_distribution<double> vertexZ(0.,5.);
+	std::vector<fastsim::Particle> particles;
+	particles.reserve(nParticles);
+	for(unsigned index = 0;index < nParticles;++index)
+	{
+	    double particlePt = 0.1 + pt(engine);
+	    double particleEta = eta(engine);
+	    double particlePhi = phi(engine);
+	    double mass = charged ? 0.13957 : 0.;
+	    double px = particlePt*std::cos(particlePhi), py = particlePt*std::sin(particlePhi), pz = particlePt*std::sinh(particleEta);
+	    double e = std::sqrt(px*px + py*py + pz*pz + mass*mass);
+	    int pdgId = charged ? (index % 2 ? 211 : -211) : 22;
+	    particles.emplace_back(pdgId,
+				   math::XYZTLorentzVector(vertexR(engine),vertexR(engine),vertexZ(engine),0.),
+				   math::XYZTLorentzVector(px,py,pz,e));
+	    particles.back().setCharge(charged ? (pdgId > 0 ? 1. : -1.) : 0.);
+	    particles.back().setStable();
+	}
+	return particles;
+    }
+
+    // charged pions and photons
+    std::vector<fastsim::Particle> makeMixedParticles()
+    {
+	std::vector<fastsim::Particle> particles = makeParticles(true,1);
+	std::vector<fastsim::Particle> neutrals = makeParticles(false,2);
+	for(const fastsim::Particle & particle : neutrals)
+	{
+	    particles.push_back(particle);
+	}
+	return particles;
+    }
+
+    void setCounters(benchmark::State & state,double steps,double particles)
+    {
+	state.counters["steps/s"] = benchmark::Counter(steps,benchmark::Counter::kIsRate);
+	state.counters["s/step"] = benchmark::Counter(steps,benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	state.counters["particles/s"] = benchmark::Counter(particles,benchmark::Counter::kIsRate);
+    }
+
+    // one step: crossing time with the next barrel layer outside the particle, and move to the crossing
+    template<bool charged>
+    void stepThroughBarrelLayers(benchmark::State & state)
+    {
+	const std::vector<fastsim::Particle> particles = makeParticles(charged);
+	const auto & layers = geometry().barrelLayers();
+	fastsim::TrajectoryVariant trajectory;
+	double steps = 0;
+	for(auto _ : state)
+	{
+	    for(const fastsim::Particle & particle : particles)
+	    {
+		trajectory.set(particle,magneticFieldZ);
+		for(const auto & layer : layers)
+		{
+		    if(charged && !trajectory->crosses(*layer))
+		    {
+			break;
+		    }
+		    double deltaTimeC = trajectory->nextCrossingTimeC(*layer);
+		    if(deltaTimeC > 0)
+		    {
+			trajectory->move(deltaTimeC);
+			++steps;
+		    }
+		}
+		benchmark::DoNotOptimize(trajectory->getPosition());
+	    }
+	}
+	setCounters(state,steps,double(state.iterations())*particles.size());
+    }
+
+    void BM_StraightTrajectory(benchmark::State & state) { stepThroughBarrelLayers<false>(state); }
+    void BM_HelixTrajectory(benchmark::State & state) { stepThroughBarrelLayers<true>(state); }
+
+    // creation of the trajectory of every navigation step (see TrajectoryVariant),
+    // followed by one crossing, in place or on the heap as before TrajectoryVariant
+    template<bool inPlace>
+    void createTrajectories(benchmark::State & state)
+    {
+	const std::vector<fastsim::Particle> particles = makeMixedParticles();
+	const fastsim::BarrelLayer & layer = *geometry().barrelLayers()[1];
+	fastsim::TrajectoryVariant trajectoryVariant;
+	for(auto _ : state)
+	{
+	    double sum = 0;
+	    for(const fastsim::Particle & particle : particles)
+	    {
+		if(inPlace)
+		{
+		    sum += trajectoryVariant.set(particle,magneticFieldZ).nextCrossingTimeC(layer);
+		}
+		else
+		{
+		    std::unique_ptr<fastsim::Trajectory> trajectory;
+		    if(particle.charge() == 0)
+		    {
+			trajectory.reset(new fastsim::StraightTrajectory(particle));
+		    }
+		    else
+		    {
+			trajectory.reset(new fastsim::HelixTrajectory(particle,magneticFieldZ));
+		    }
+		    sum += trajectory->nextCrossingTimeC(layer);
+		}
+	    }
+	    benchmark::DoNotOptimize(sum);
+	}
+	state.counters["trajectories/s"] = benchmark::Counter(double(state.iterations())*particles.size(),benchmark::Counter::kIsRate);
+    }
+
+    void BM_TrajectoryCreation_InPlace(benchmark::State & state) { createTrajectories<true>(state); }
+    void BM_TrajectoryCreation_Heap(benchmark::State & state) { createTrajectories<false>(state); }
+
+    // full navigation of each particle through all layers it crosses, without interactions
+    template<bool charged>
+    void navigate(benchmark::State & state)
+    {
+	const std::vector<fastsim::Particle> particles = makeParticles(charged);
+	fastsim::LayerNavigator navigator(geometry());
+	double steps = 0;
+	for(auto _ : state)
+	{
+	    for(const fastsim::Particle & templateParticle : particles)
+	    {
+		fastsim::Particle particle(templateParticle);
+		const fastsim::Layer * layer = 0;
+		while(navigator.moveParticleToNextLayer(particle,layer))
+		{
+		    ++steps;
+		}
+		benchmark::DoNotOptimize(particle.position());
+	    }
+	}
+	setCounters(state,steps,double(state.iterations())*particles.size());
+    }
+
+    void BM_LayerNavigator_Neutral(benchmark::State & state) { navigate<false>(state); }
+    void BM_LayerNavigator_Charged(benchmark::State & state) { navigate<true>(state); }
+
+    // cost of the instrumentation (see Instrumentation.h) on the navigation of charged particles,
+    // with the timers of the steps of FastSimProducer (navigation and layer), argument: instrumentation enabled
+    void BM_LayerNavigator_Charged_Instrumentation(benchmark::State & state)
+    {
+	const std::vector<fastsim::Particle> particles = makeParticles(true);
+	fastsim::LayerNavigator navigator(geometry());
+	fastsim::Instrumentation instrumentation(state.range(0),std::vector<std::string>());
+	double steps = 0;
+	for(auto _ : state)
+	{
+	    for(const fastsim::Particle & templateParticle : particles)
+	    {
+		fastsim::Particle particle(templateParticle);
+		const fastsim::Layer * layer = 0;
+		while(true)
+		{
+		    fastsim::Instrumentation::Timer navigationTimer(instrumentation.navigation());
+		    if(!navigator.moveParticleToNextLayer(particle,layer))
+		    {
+			break;
+		    }
+		    navigationTimer.stop(0);
+		    fastsim::Instrumentation::Timer layerTimer(instrumentation.layer(layer->isForward(),layer->index()));
+		    ++steps;
+		}
+		benchmark::DoNotOptimize(particle.position());
+	    }
+	}
+	setCounters(state,steps,double(state.iterations())*particles.size());
+    }
+
+    // secondary vertices, where the navigation of secondaries starts (see LayerNavigator):
+    //    - half of them on the material of a layer (nuclear interactions, conversions, bremsstrahlung),
+    //      the layer chosen with a probability proportional to its material (thickness times extent)
+    //    - half of them decays in flight, at r exponential with mean 5 cm (K0S, Lambda), |eta| < 2.5
+    std::vector<fastsim::Particle> makeSecondaries(unsigned seed = 3)
+    {
+	std::mt19937 engine(seed);
+	std::uniform_real_distribution<double> uniform(0.,1.);
+	std::exponential_distribution<double> decayR(0.2);
+	// material of each layer (barrel layers first, forward layers once per side)
+	std::vector<const fastsim::test::SyntheticLayer *> layers;
+	std::vector<bool> isForward;
+	std::vector<double> material;
+	for(bool forward : {false,true})
+	{
+	    for(const fastsim::test::SyntheticLayer & layer : forward ? fastsim::test::syntheticForwardLayers() : fastsim::test::syntheticBarrelLayers())
+	    {
+		double sum = 0;
+		for(unsigned bin = 0;bin < layer.thickness.size();++bin)
+		{
+		    sum += layer.thickness[bin] * (layer.limits[bin + 1] - layer.limits[bin]);
+		}
+		layers.push_back(&layer);
+		isForward.push_back(forward);
+		material.push_back(sum);
+	    }
+	}
+	std::discrete_distribution<unsigned> chooseLayer(material.begin(),material.end());
+
+	std::vector<fastsim::Particle> particles;
+	particles.reserve(nParticles);
+	for(unsigned index = 0;index < nParticles;++index)
+	{
+	    double phi = 2. * M_PI * uniform(engine);
+	    double r, z;
+	    if(index % 2)
+	    {
+		unsigned layerIndex = chooseLayer(engine);
+		const fastsim::test::SyntheticLayer & layer = *layers[layerIndex];
+		double sign = uniform(engine) < 0.5 ? -1. : 1.;
+		double extent = layer.limits.front() + (layer.limits.back() - layer.limits.front()) * uniform(engine);
+		r = isForward[layerIndex] ? extent : layer.position;
+		z = isForward[layerIndex] ? sign * layer.position : sign * extent;
+	    }
+	    else
+	    {
+		r = std::min(decayR(engine),119.);
+		z = std::max(std::min(r * std::sinh(5. * uniform(engine) - 2.5),299.),-299.);
+	    }
+	    double momentumPhi = 2. * M_PI * uniform(engine);
+	    double pz = 2. * uniform(engine) - 1.;
+	    particles.emplace_back(211,
+				   math::XYZTLorentzVector(r * std::cos(phi),r * std::sin(phi),z,0.),
+				   math::XYZTLorentzVector(std::cos(momentumPhi),std::sin(momentumPhi),pz,std::sqrt(1. + pz*pz + 0.13957*0.13957)));
+	    particles.back().setCharge(1.);
+	    particles.back().setStable();
+	}
+	return particles;
+    }
+
+    // the layers enclosing a new particle, as found by LayerNavigator at the start of the navigation:
+    // the scan starts at the first layer (as LayerNavigator did before) or at a binary search result
+    template<bool binarySearch>
+    void locateLayers(benchmark::State & state)
+    {
+	const std::vector<fastsim::Particle> particles = makeSecondaries();
+	const auto & barrelLayers = geometry().barrelLayers();
+	const auto & forwardLayers = geometry().forwardLayers();
+	for(auto _ : state)
+	{
+	    unsigned sum = 0;
+	    for(const fastsim::Particle & particle : particles)
+	    {
+		const math::XYZTLorentzVector & position = particle.position();
+		bool movesInwards = particle.momentum().Vect().Dot(position.Vect()) < 0;
+		unsigned index = binarySearch ? geometry().lowerBoundBarrelLayer(position.Pt() - 2.*fastsim::Layer::epsilonDistanceR_) : 0;
+		for(;index < barrelLayers.size();++index)
+		{
+		    if(barrelLayers[index]->isOnSurface(position) ? movesInwards : position.Pt() < barrelLayers[index]->getRadius())
+		    {
+			break;
+		    }
+		}
+		sum += index;
+		index = binarySearch ? geometry().lowerBoundForwardLayer(position.Z() - 2.*fastsim::Layer::epsilonDistanceZ_) : 0;
+		for(;index < forwardLayers.size();++index)
+		{
+		    if(forwardLayers[index]->isOnSurface(position) ? particle.momentum().Z() < 0 : position.Z() < forwardLayers[index]->getZ())
+		    {
+			break;
+		    }
+		}
+		sum += index;
+	    }
+	    benchmark::DoNotOptimize(sum);
+	}
+	state.counters["particles/s"] = benchmark::Counter(double(state.iterations())*particles.size(),benchmark::Counter::kIsRate);
+    }
+
+    void BM_LocateLayers_LinearScan(benchmark::State & state) { locateLayers<false>(state); }
+    void BM_LocateLayers_BinarySearch(benchmark::State & state) { locateLayers<true>(state); }
+
+    // first navigation step of secondaries: locating the layers and the first crossing
+    void BM_LayerNavigator_SecondaryFirstStep(benchmark::State & state)
+    {
+	const std::vector<fastsim::Particle> particles = makeSecondaries();
+	fastsim::LayerNavigator navigator(geometry());
+	double steps = 0;
+	for(auto _ : state)
+	{
+	    for(const fastsim::Particle & templateParticle : particles)
+	    {
+		fastsim::Particle particle(templateParticle);
+		const fastsim::Layer * layer = 0;
+		steps += navigator.moveParticleToNextLayer(particle,layer);
+		benchmark::DoNotOptimize(particle.position());
+	    }
+	}
+	setCounters(state,steps,double(state.iterations())*particles.size());
+    }
+
+    // particle filter of fastSimProducer_cff.py on a mix of charged and neutral particles
+    fastsim::ParticleFilter makeParticleFilter()
+    {
+	edm::ParameterSet cfg;
+	cfg.addParameter<double>("chargedPtMin",0.1);
+	cfg.addParameter<double>("EMin",0.1);
+	cfg.addParameter<double>("protonEMin",5000.);
+	cfg.addParameter<double>("etaMax",5.3);
+	cfg.addParameter<double>("vertexRMax",129.0);
+	cfg.addParameter<double>("vertexZMax",317.0);
+	return fastsim::ParticleFilter(cfg);
+    }
+
+    void BM_ParticleFilter(benchmark::State & state)
+    {
+	const fastsim::ParticleFilter filter = makeParticleFilter();
+	const std::vector<fastsim::Particle> particles = makeMixedParticles();
+	for(auto _ : state)
+	{
+	    unsigned accepted = 0;
+	    for(const fastsim::Particle & particle : particles)
+	    {
+		accepted += filter.accepts(particle);
+	    }
+	    benchmark::DoNotOptimize(accepted);
+	}
+	state.counters["particles/s"] = benchmark::Counter(double(state.iterations())*particles.size(),benchmark::Counter::kIsRate);
+    }
+
+    void BM_ParticleFilter_Batch(benchmark::State & state)
+    {
+	const fastsim::ParticleFilter filter = makeParticleFilter();
+	const std::vector<fastsim::Particle> particles = makeMixedParticles();
+	std::vector<int> pdgId;
+	std::vector<double> charge, x, y, z, px, py, pz, e;
+	for(const fastsim::Particle & particle : particles)
+	{
+	    pdgId.push_back(particle.pdgId());
+	    charge.push_back(particle.charge());
+	    x.push_back(particle.position().X());
+	    y.push_back(particle.position().Y());
+	    z.push_back(particle.position().Z());
+	    px.push_back(particle.momentum().Px());
+	    py.push_back(particle.momentum().Py());
+	    pz.push_back(particle.momentum().Pz());
+	    e.push_back(particle.momentum().E());
+	}
+	fastsim::ParticleFilter::Particles batch = {unsigned(particles.size()),pdgId.data(),charge.data(),
+						     x.data(),y.data(),z.data(),px.data(),py.data(),pz.data(),e.data()};
+	std::vector<unsigned char> accept;
+	for(auto _ : state)
+	{
+	    filter.accepts(batch,accept);
+	    benchmark::DoNotOptimize(accept.data());
+	}
+	state.counters["particles/s"] = benchmark::Counter(double(state.iterations())*particles.size(),benchmark::Counter::kIsRate);
+    }
+}
+
+BENCHMARK(BM_StraightTrajectory);
+BENCHMARK(BM_HelixTrajectory);
+BENCHMARK(BM_TrajectoryCreation_InPlace);
+BENCHMARK(BM_TrajectoryCreation_Heap);
+BENCHMARK(BM_LayerNavigator_Neutral);
+BENCHMARK(BM_LayerNavigator_Charged);
+BENCHMARK(BM_LayerNavigator_Charged_Instrumentation)->Arg(0)->Arg(1);
+BENCHMARK(BM_LocateLayers_LinearScan);
+BENCHMARK(BM_LocateLayers_BinarySearch);
+BENCHMARK(BM_LayerNavigator_SecondaryFirstStep);
+BENCHMARK(BM_ParticleFilter);
+BENCHMARK(BM_ParticleFilter_Batch);
+
+BENCHMARK_MAIN();
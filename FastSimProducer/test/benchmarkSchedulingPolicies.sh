@@ -0,0 +1,36 @@
+#!/bin/sh
+# compare the scheduling policies of fastSimProducer (schedulingPolicy) on ttbar and single electron events
+# for each sample and policy: the timing summary of cmsRun and the instrumentation summary of fastSimProducer
+# run from the src directory of a CMSSW area with FastSimulation/FastSimProducer built
+# (number of events: NEVENTS, default 100)
+# no results are quoted anywhere yet: the policies other than depthFirst come without a measured speedup
+
+NEVENTS=${NEVENTS:-100}
+POLICIES="depthFirst breadthFirst energyOrdered layerLocality"
+
+# generator events
+[ -f gen_ttbar.root ] || cmsDriver.py TTbar_13TeV_TuneCUETP8M1_cfi --conditions auto:run2_mc --fast -n $NEVENTS --era Run2_2016 --eventcontent FEVTDEBUGHLT --relval 9000,100 -s GEN --datatier GEN-SIM-DIGI-RECO --beamspot Realistic50ns13TeVCollision --fileout gen_ttbar.root --python_filename gen_ttbar_cfg.py || exit 1
+[ -f gen_singleElectron.root ] || cmsDriver.py SingleElectronPt10_pythia8_cfi --conditions auto:run2_mc --fast -n $NEVENTS --era Run2_2016 --eventcontent FEVTDEBUGHLT --relval 9000,100 -s GEN --datatier GEN-SIM-DIGI-RECO --beamspot Realistic50ns13TeVCollision --fileout gen_singleElectron.root --python_filename gen_singleElectron_cfg.py || exit 1
+
+for SAMPLE in ttbar singleElectron; do
+    for POLICY in $POLICIES; do
+	NAME=${SAMPLE}_${POLICY}
+	cat > benchmark_${NAME}_cfg.py <<END
+import FWCore.ParameterSet.Config as cms
+from FastSimulation.FastSimProducer.conf_cfg import process
+process.source.fileNames = cms.untracked.vstring('file:gen_${SAMPLE}.root')
+process.maxEvents.input = ${NEVENTS}
+process.fastSimProducer.schedulingPolicy = '${POLICY}'
+process.fastSimProducer.instrument = True
+process.fastSimProducer.instrumentationFile = 'instrumentation_${NAME}.txt'
+# only the simulation: no reconstruction, no output
+process.schedule = cms.Schedule(process.simulation_step)
+process.MessageLogger.cout.threshold = 'INFO'
+process.Timing = cms.Service('Timing', summaryOnly = cms.untracked.bool(True))
+END
+	echo "=== ${NAME}"
+	cmsRun benchmark_${NAME}_cfg.py > benchmark_${NAME}.log 2>&1 || { echo "cmsRun failed, see benchmark_${NAME}.log"; continue; }
+	grep -A6 "Time Summary" benchmark_${NAME}.log
+	cat instrumentation_${NAME}.txt
+    done
+done
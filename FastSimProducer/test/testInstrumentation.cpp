@@ -0,0 +1,134 @@
+#include "FastSimulation/FastSimProducer/interface/Instrumentation.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    const std::vector<std::string> interactionModelNames = {"trackerSimHits","bremsstrahlung"};
+
+    // calls and secondaries as in FastSimProducer: one navigation step,
+    // then the models of the layer, each with its secondaries
+    void step(fastsim::Instrumentation & instrumentation,bool isForward,unsigned layerIndex,const std::vector<unsigned> & secondariesPerModel)
+    {
+	fastsim::Instrumentation::Timer navigationTimer(instrumentation.navigation());
+	navigationTimer.stop(0);
+	fastsim::Instrumentation::Timer layerTimer(instrumentation.layer(isForward,layerIndex));
+	unsigned nSecondaries = 0;
+	for(unsigned index = 0;index < secondariesPerModel.size();++index)
+	{
+	    fastsim::Instrumentation::Timer interactionTimer(instrumentation.interactionModel(index));
+	    interactionTimer.stop(secondariesPerModel[index]);
+	    nSecondaries += secondariesPerModel[index];
+	}
+	layerTimer.stop(nSecondaries);
+    }
+
+    // counters of write(), by "<category> <name>": calls and secondaries
+    std::map<std::string,std::pair<unsigned long long,unsigned long long> > readCounters(const fastsim::Instrumentation & instrumentation)
+    {
+	std::ostringstream os;
+	instrumentation.write(os);
+	std::istringstream is(os.str());
+	std::map<std::string,std::pair<unsigned long long,unsigned long long> > counters;
+	std::string line;
+	std::getline(is,line);
+	EXPECT_EQ("# category name calls seconds secondaries",line);
+	std::string category, name;
+	unsigned long long calls, secondaries;
+	double seconds;
+	while(is >> category >> name >> calls >> seconds >> secondaries)
+	{
+	    EXPECT_GE(seconds,0.);
+	    counters[category + " " + name] = std::make_pair(calls,secondaries);
+	}
+	return counters;
+    }
+}
+
+TEST(Instrumentation, CountsPerModelAndLayer)
+{
+    fastsim::Instrumentation instrumentation(true,interactionModelNames);
+    step(instrumentation,false,3,{0,1});
+    step(instrumentation,false,3,{2,0});
+    step(instrumentation,true,1,{0,4});
+    {
+	fastsim::Instrumentation::Timer decayTimer(instrumentation.decay());
+	decayTimer.stop(2);
+    }
+    // a timer that is not stopped counts a call without secondaries
+    {
+	fastsim::Instrumentation::Timer navigationTimer(instrumentation.navigation());
+    }
+
+    EXPECT_EQ(4u,instrumentation.navigation()->calls);
+    EXPECT_EQ(0u,instrumentation.navigation()->secondaries);
+    EXPECT_EQ(1u,instrumentation.decay()->calls);
+    EXPECT_EQ(2u,instrumentation.decay()->secondaries);
+    EXPECT_EQ(3u,instrumentation.interactionModel(0)->calls);
+    EXPECT_EQ(2u,instrumentation.interactionModel(0)->secondaries);
+    EXPECT_EQ(3u,instrumentation.interactionModel(1)->calls);
+    EXPECT_EQ(5u,instrumentation.interactionModel(1)->secondaries);
+    EXPECT_EQ(2u,instrumentation.layer(false,3)->calls);
+    EXPECT_EQ(3u,instrumentation.layer(false,3)->secondaries);
+    EXPECT_EQ(0u,instrumentation.layer(false,0)->calls);
+    EXPECT_EQ(1u,instrumentation.layer(true,1)->calls);
+    EXPECT_EQ(4u,instrumentation.layer(true,1)->secondaries);
+
+    // the file written at the end of the job has the same counters
+    std::map<std::string,std::pair<unsigned long long,unsigned long long> > counters = readCounters(instrumentation);
+    EXPECT_EQ(std::make_pair(4ull,0ull),counters["step navigation"]);
+    EXPECT_EQ(std::make_pair(1ull,2ull),counters["step decay"]);
+    EXPECT_EQ(std::make_pair(3ull,2ull),counters["interactionModel trackerSimHits"]);
+    EXPECT_EQ(std::make_pair(3ull,5ull),counters["interactionModel bremsstrahlung"]);
+    EXPECT_EQ(std::make_pair(2ull,3ull),counters["barrelLayer 3"]);
+    EXPECT_EQ(std::make_pair(1ull,4ull),counters["forwardLayer 1"]);
+    EXPECT_EQ(1u,counters.count("barrelLayer 0"));
+    EXPECT_EQ(0u,counters.count("barrelLayer 4"));
+}
+
+TEST(Instrumentation, MergeOfStreams)
+{
+    fastsim::Instrumentation total(true,interactionModelNames);
+    fastsim::Instrumentation stream1(true,interactionModelNames);
+    fastsim::Instrumentation stream2(true,interactionModelNames);
+    step(stream1,false,1,{1,1});
+    step(stream2,false,5,{0,3});
+    step(stream2,true,2,{1,0});
+    total.merge(stream1);
+    total.merge(stream2);
+
+    EXPECT_EQ(3u,total.navigation()->calls);
+    EXPECT_EQ(3u,total.interactionModel(0)->calls);
+    EXPECT_EQ(2u,total.interactionModel(0)->secondaries);
+    EXPECT_EQ(4u,total.interactionModel(1)->secondaries);
+    EXPECT_EQ(1u,total.layer(false,1)->calls);
+    EXPECT_EQ(3u,total.layer(false,5)->secondaries);
+    EXPECT_EQ(1u,total.layer(true,2)->secondaries);
+    EXPECT_DOUBLE_EQ(stream1.navigation()->seconds + stream2.navigation()->seconds,total.navigation()->seconds);
+
+    fastsim::Instrumentation otherModels(true,{"trackerSimHits"});
+    EXPECT_THROW(total.merge(otherModels),cms::Exception);
+}
+
+TEST(Instrumentation, DisabledCountsNothing)
+{
+    fastsim::Instrumentation instrumentation(false,interactionModelNames);
+    EXPECT_FALSE(instrumentation.enabled());
+    EXPECT_EQ(0,instrumentation.navigation());
+    EXPECT_EQ(0,instrumentation.decay());
+    EXPECT_EQ(0,instrumentation.interactionModel(0));
+    EXPECT_EQ(0,instrumentation.layer(false,3));
+    step(instrumentation,false,3,{1,2});
+
+    std::map<std::string,std::pair<unsigned long long,unsigned long long> > counters = readCounters(instrumentation);
+    EXPECT_EQ(std::make_pair(0ull,0ull),counters["step navigation"]);
+    EXPECT_EQ(std::make_pair(0ull,0ull),counters["interactionModel bremsstrahlung"]);
+    EXPECT_EQ(0u,counters.count("barrelLayer 3"));
+}
@@ -0,0 +1,152 @@
+#include "FastSimulation/FastSimProducer/interface/ParticleFilter.h"
+#include "FastSimulation/NewParticle/interface/Particle.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const double chargedPtMin = 0.1, EMin = 0.1, protonEMin = 5000., etaMax = 5.3;
+    const double vertexRMax = 129.0, vertexZMax = 317.0;
+
+    fastsim::ParticleFilter makeParticleFilter()
+    {
+	edm::ParameterSet cfg;
+	cfg.addParameter<double>("chargedPtMin",chargedPtMin);
+	cfg.addParameter<double>("EMin",EMin);
+	cfg.addParameter<double>("protonEMin",protonEMin);
+	cfg.addParameter<double>("etaMax",etaMax);
+	cfg.addParameter<double>("vertexRMax",vertexRMax);
+	cfg.addParameter<double>("vertexZMax",vertexZMax);
+	return fastsim::ParticleFilter(cfg);
+    }
+
+    // the cuts one by one, with branches
+    bool referenceAccepts(const fastsim::Particle & particle)
+    {
+	int pId = std::abs(particle.pdgId());
+	if(pId == 12 || pId == 14 || pId == 16 || pId == 1000022)
+	{
+	    return false;
+	}
+	if(pId == 2212 && particle.momentum().E() >= protonEMin)
+	{
+	    return true;
+	}
+	if(particle.momentum().E() < EMin)
+	{
+	    return false;
+	}
+	if(particle.charge() != 0 && particle.momentum().Perp2() < chargedPtMin*chargedPtMin)
+	{
+	    return false;
+	}
+	double cosThetaMax = std::tanh(etaMax);
+	if(particle.position().Perp2() < 25. && std::abs(particle.momentum().Pz()) / particle.momentum().P() > cosThetaMax)
+	{
+	    return false;
+	}
+	return particle.position().Perp2() < vertexRMax*vertexRMax && std::abs(particle.position().Z()) < vertexZMax;
+    }
+
+    // particles around all the cuts: energies around EMin and protonEMin, pt around chargedPtMin,
+    // eta around etaMax, vertices around the beam (r = 5) and the ECAL volume
+    std::vector<fastsim::Particle> makeParticles(unsigned n,bool setCharge)
+    {
+	std::mt19937 engine(4321);
+	std::uniform_real_distribution<double> uniform(0.,1.);
+	const std::vector<int> pdgIds = {11,-11,13,-13,211,-211,321,2212,-2212,22,130,2112,12,-14,16,1000022};
+	const std::vector<double> charges = {-1.,1.,-1.,1.,1.,-1.,1.,1.,-1.,0.,0.,0.,0.,0.,0.,0.};
+	const std::vector<double> energies = {0.05,EMin,0.5,10.,protonEMin,1.2*protonEMin};
+	const std::vector<double> pts = {0.05,chargedPtMin,0.3,2.};
+	const std::vector<double> etas = {0.,2.,etaMax - 0.01,etaMax + 0.01,7.};
+	const std::vector<double> radii = {0.,4.9,5.1,100.,vertexRMax - 0.1,vertexRMax + 0.1};
+	const std::vector<double> zs = {0.,100.,vertexZMax - 0.1,vertexZMax + 0.1};
+	std::vector<fastsim::Particle> particles;
+	for(unsigned i = 0;i < n;++i)
+	{
+	    unsigned type = engine() % pdgIds.size();
+	    double e = energies[engine() % energies.size()] * (0.99 + 0.02*uniform(engine));
+	    double pt = pts[engine() % pts.size()] * (0.99 + 0.02*uniform(engine));
+	    double eta = etas[engine() % etas.size()] * (engine() % 2 ? 1. : -1.);
+	    double phi = 2.*M_PI*uniform(engine);
+	    double r = radii[engine() % radii.size()];
+	    double z = zs[engine() % zs.size()] * (engine() % 2 ? 1. : -1.);
+	    particles.emplace_back(pdgIds[type],
+				   math::XYZTLorentzVector(r*std::cos(phi),r*std::sin(phi),z,0.),
+				   math::XYZTLorentzVector(pt*std::cos(phi),pt*std::sin(phi),pt*std::sinh(eta),e));
+	    if(setCharge)
+	    {
+		particles.back().setCharge(charges[type]);
+	    }
+	}
+	return particles;
+    }
+
+    void expectSameDecisions(bool setCharge)
+    {
+	const fastsim::ParticleFilter filter = makeParticleFilter();
+	const std::vector<fastsim::Particle> particles = makeParticles(100000,setCharge);
+
+	std::vector<int> pdgId;
+	std::vector<double> charge, x, y, z, px, py, pz, e;
+	std::vector<std::unique_ptr<fastsim::Particle> > particlePtrs;
+	for(const fastsim::Particle & particle : particles)
+	{
+	    pdgId.push_back(particle.pdgId());
+	    charge.push_back(particle.charge());
+	    x.push_back(particle.position().X());
+	    y.push_back(particle.position().Y());
+	    z.push_back(particle.position().Z());
+	    px.push_back(particle.momentum().Px());
+	    py.push_back(particle.momentum().Py());
+	    pz.push_back(particle.momentum().Pz());
+	    e.push_back(particle.momentum().E());
+	    particlePtrs.emplace_back(new fastsim::Particle(particle));
+	}
+	// without charges, the particles count as charged (as a particle with unset charge)
+	fastsim::ParticleFilter::Particles batch = {unsigned(particles.size()),pdgId.data(),setCharge ? charge.data() : 0,
+						     x.data(),y.data(),z.data(),px.data(),py.data(),pz.data(),e.data()};
+	std::vector<unsigned char> accept, acceptPtrs;
+	filter.accepts(batch,accept);
+	filter.accepts(particlePtrs,acceptPtrs);
+	ASSERT_EQ(particles.size(),accept.size());
+	ASSERT_EQ(particles.size(),acceptPtrs.size());
+
+	unsigned nAccepted = 0;
+	for(unsigned index = 0;index < particles.size();++index)
+	{
+	    bool accepted = filter.accepts(particles[index]);
+	    EXPECT_EQ(referenceAccepts(particles[index]),accepted) << "particle " << index;
+	    EXPECT_EQ(accepted,bool(accept[index])) << "particle " << index;
+	    EXPECT_EQ(accepted,bool(acceptPtrs[index])) << "particle " << index;
+	    nAccepted += accepted;
+	}
+	// both decisions occur often
+	EXPECT_GT(nAccepted,particles.size() / 10);
+	EXPECT_LT(nAccepted,particles.size() * 9 / 10);
+    }
+}
+
+TEST(ParticleFilter, BatchAndScalarAgree)
+{
+    expectSameDecisions(true);
+}
+
+TEST(ParticleFilter, BatchAndScalarAgreeWithoutCharge)
+{
+    expectSameDecisions(false);
+}
+
+TEST(ParticleFilter, VertexVolumeIsConfigured)
+{
+    const fastsim::ParticleFilter filter = makeParticleFilter();
+    EXPECT_TRUE(filter.accepts(math::XYZTLorentzVector(vertexRMax - 0.1,0.,vertexZMax - 0.1,0.)));
+    EXPECT_FALSE(filter.accepts(math::XYZTLorentzVector(vertexRMax + 0.1,0.,0.,0.)));
+    EXPECT_FALSE(filter.accepts(math::XYZTLorentzVector(0.,0.,-vertexZMax - 0.1,0.)));
+}
@@ -0,0 +1,15 @@
+#ifndef FASTSIM_FASTSIMGEOMETRYRECORD_H
+#define FASTSIM_FASTSIMGEOMETRYRECORD_H
+
+#include "FWCore/Framework/interface/DependentRecordImplementation.h"
+#include "RecoTracker/Record/interface/TrackerRecoGeometryRecord.h"
+#include "MagneticField/Records/interface/IdealMagneticFieldRecord.h"
+
+#include "boost/mpl/vector.hpp"
+
+// record for the fastsim::Geometry
+// the geometry must be rebuilt whenever the tracker geometry or the magnetic field change
+class FastSimGeometryRecord : public edm::eventsetup::DependentRecordImplementation<FastSimGeometryRecord,
+    boost::mpl::vector<TrackerRecoGeometryRecord,IdealMagneticFieldRecord> > {};
+
+#endif
@@ -7,16 +7,16 @@
 
 class GeometricSearchTracker;
 class MagneticField;
+class FastSimGeometryRecord;
 
+#include <algorithm>
 #include <vector>
 
 namespace edm { 
     class ParameterSet;
-    class EventSetup;
 }
 
 namespace fastsim{
-    class InteractionModel;
     class Geometry
     {
     public:
@@ -26,7 +26,15 @@ namespace fastsim{
 	/// Destructor
 	~Geometry();
 
-	void update(const edm::EventSetup & iSetup,const std::map<std::string,InteractionModel*> & interactionModelMap);
+	// (re)build the layers
+	// the geometry is an EventSetup product (see GeometryESProducer), shared read-only by all streams
+	void update(const FastSimGeometryRecord & iRecord);
+
+	// (re)build the layers from explicitly provided conditions, without access to the EventSetup
+	// (e.g. to exercise navigation and propagation outside of cmsRun)
+	// geometricSearchTracker may be 0: layers are then built without DetLayer and need an explicit radius / z
+	// magneticField may be 0 if a fixed magnetic field is configured (magneticFieldZ), it is ignored in that case
+	void update(const GeometricSearchTracker * geometricSearchTracker,const MagneticField * magneticField);
 
 	// Returns the magnetic field
 	double getMagneticFieldZ(const math::XYZTLorentzVector & position) const;
@@ -34,8 +42,25 @@ namespace fastsim{
 	const std::vector<std::unique_ptr<BarrelLayer> >& barrelLayers() const { return barrelLayers_; }
 	const std::vector<std::unique_ptr<ForwardLayer> >& forwardLayers() const { return forwardLayers_; }
 	
-	double getMaxRadius() { return maxRadius_;}
-	double getMaxZ() { return maxZ_;}
+	// radii (z positions) of the barrel (forward) layers, in the order of the layers, i.e. increasing
+	const std::vector<double> & barrelLayerRadii() const { return barrelLayerRadii_; }
+	const std::vector<double> & forwardLayerZ() const { return forwardLayerZ_; }
+
+	// index of the first barrel (forward) layer with radius (z) >= the given value,
+	// or the number of barrel (forward) layers if there is none: binary search
+	unsigned lowerBoundBarrelLayer(double radius) const
+	{
+	    return std::lower_bound(barrelLayerRadii_.begin(),barrelLayerRadii_.end(),radius) - barrelLayerRadii_.begin();
+	}
+	unsigned lowerBoundForwardLayer(double z) const
+	{
+	    return std::lower_bound(forwardLayerZ_.begin(),forwardLayerZ_.end(),z) - forwardLayerZ_.begin();
+	}
+
+	// tracker volume: all layers, including their material, are inside r <= maxRadius and |z| <= maxZ
+	// (checked by update, layers on the boundary are allowed)
+	double getMaxRadius() const { return maxRadius_;}
+	double getMaxZ() const { return maxZ_;}
 	
 
 	friend std::ostream& operator << (std::ostream& o , const fastsim::Geometry & geometry); 
@@ -83,6 +108,8 @@ namespace fastsim{
 
 	std::vector<std::unique_ptr<BarrelLayer> >barrelLayers_;
 	std::vector<std::unique_ptr<ForwardLayer> > forwardLayers_;
+	std::vector<double> barrelLayerRadii_;
+	std::vector<double> forwardLayerZ_;
 	std::unique_ptr<MagneticField> ownedMagneticField_;
 
 	const MagneticField * magneticField_;
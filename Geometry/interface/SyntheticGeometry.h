@@ -0,0 +1,120 @@
+#ifndef FASTSIM_SYNTHETICGEOMETRY_H
+#define FASTSIM_SYNTHETICGEOMETRY_H
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FastSimulation/Geometry/interface/Geometry.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// a fastsim::Geometry for tests and benchmarks, built without EventSetup, tracker geometry or field map:
+//    - the layers of Geometry/python/TrackerMaterial_cfi.py (position, material limits and thickness)
+//    - the active forward layers take their z from the DetLayers in the cfi: here approximate values are used
+//    - no layer has a DetLayer (see Geometry::update), the magnetic field is uniform
+namespace fastsim
+{
+    namespace test
+    {
+	struct SyntheticLayer
+	{
+	    double position; // radius (barrel) or z (forward)
+	    std::vector<double> limits;
+	    std::vector<double> thickness;
+	};
+
+	inline const std::vector<SyntheticLayer> & syntheticBarrelLayers()
+	{
+	    static const std::vector<SyntheticLayer> layers = {
+		{3.003,{0.0,28.3},{0.0024}}, // PIPE
+		{4.425,{0.0,28.391},{0.0217}}, // BPix1
+		{7.312,{0.0,28.391},{0.0217}}, // BPix2
+		{10.177,{0.0,28.391},{0.0217}}, // BPix3
+		{17.6,{0.0,27.5,32.0,65.0},{0.0135,0.095,0.050}},
+		{25.767,{0.0,35.0,65.254},{0.053,0.0769}}, // TIB1
+		{34.104,{0.0,35.0,65.231},{0.053,0.0769}}, // TIB2
+		{41.974,{0.0,35.0,66.232},{0.035,0.0508}}, // TIB3
+		{49.907,{0.0,35.0,66.355},{0.04,0.058}}, // TIB4
+		{55.1,{0.0,27.5,30.5,72.0,108.2},{0.009,0.036,0.009,0.0495}},
+		{60.937,{0.0,18.0,30.0,36.0,46.0,55.0,108.737},{0.021,0.06,0.03,0.06,0.03,0.06}}, // TOB1
+		{69.322,{0.0,18.0,30.0,36.0,46.0,55.0,108.737},{0.021,0.06,0.03,0.06,0.03,0.06}}, // TOB2
+		{78.081,{0.0,18.0,30.0,36.0,46.0,55.0,108.737},{0.0154,0.044,0.022,0.044,0.022,0.044}}, // TOB3
+		{86.876,{0.0,18.0,30.0,36.0,46.0,55.0,108.737},{0.0154,0.044,0.022,0.044,0.022,0.044}}, // TOB4
+		{96.569,{0.0,18.0,30.0,36.0,46.0,55.0,108.737},{0.0154,0.044,0.022,0.044,0.022,0.044}}, // TOB5
+		{108.063,{0.0,18.0,30.0,36.0,46.0,55.0,108.737},{0.0154,0.044,0.022,0.044,0.022,0.044}}, // TOB6
+		{120.0,{0.0,120.0,299.9},{0.042,0.1596}}
+	    };
+	    return layers;
+	}
+
+	inline const std::vector<SyntheticLayer> & syntheticForwardLayers()
+	{
+	    static const std::vector<SyntheticLayer> layers = {
+		{28.799,{4.2,5.1,7.1,8.2,10.0,11.0,11.9,16.5},{0.100,0.00,0.108,0.00,0.112,0.02,0.04}},
+		{28.8,{3.8,16.5},{0.012}},
+		{34.5,{4.825,16.598},{0.058}}, // FPix1, approximate z
+		{46.5,{4.823,16.598},{0.058}}, // FPix2, approximate z
+		{65.1,{6.5,10.0,11.0,16.0,17.61},{0.150,0.325,0.250,0.175}},
+		{74.0,{22.5,53.9},{0.130}},
+		{80.0,{22.2,34.0,42.0,53.940},{0.04,0.08,0.04}}, // TID1, approximate z
+		{92.0,{22.2,34.0,42.0,53.942},{0.04,0.08,0.04}}, // TID2, approximate z
+		{104.0,{22.2,34.0,42.0,53.942},{0.055,0.110,0.055}}, // TID3, approximate z
+		{108.0,{22.0,24.0,47.5,54.943},{0.111,0.074,0.185}},
+		{115.0,{55.0,60.0,62.0,78.0,92.0,111.0},{0.005,0.009,0.014,0.016,0.009}},
+		{127.5,{21.87,24.0,34.0,39.0,111.395},{0.100,0.040,0.080,0.050}}, // TEC1, approximate z
+		{141.5,{21.87,24.0,34.0,39.0,111.395},{0.100,0.040,0.080,0.050}}, // TEC2, approximate z
+		{155.5,{21.87,24.0,34.0,39.0,111.395},{0.100,0.040,0.080,0.050}}, // TEC3, approximate z
+		{169.5,{29.62,32.0,40.0,41.0,46.0,111.395},{0.115,0.030,0.050,0.070,0.050}}, // TEC4, approximate z
+		{183.5,{29.62,32.0,40.0,41.0,46.0,111.395},{0.115,0.030,0.050,0.070,0.050}}, // TEC5, approximate z
+		{199.5,{29.62,32.0,40.0,41.0,46.0,111.395},{0.125,0.030,0.050,0.070,0.050}}, // TEC6, approximate z
+		{218.0,{29.71,32.0,60.0,111.395},{0.135,0.030,0.050}}, // TEC7, approximate z
+		{239.0,{29.71,32.0,60.0,111.395},{0.150,0.030,0.050}}, // TEC8, approximate z
+		{262.0,{29.91,32.0,60.0,111.395},{0.150,0.030,0.050}}, // TEC9, approximate z
+		{300.0,{4.42,4.65,4.84,7.37,10.99,14.70,16.24,22.00,28.50,31.50,36.0,120.0},{3.935,0.483,0.127,0.089,0.069,0.124,1.47,0.924,0.693,0.294,0.336}}
+	    };
+	    return layers;
+	}
+
+	inline edm::ParameterSet syntheticLayerConfig(const SyntheticLayer & layer,bool isForward)
+	{
+	    edm::ParameterSet cfg;
+	    cfg.addUntrackedParameter<double>(isForward ? "z" : "radius",layer.position);
+	    cfg.addUntrackedParameter<std::vector<double> >("limits",layer.limits);
+	    cfg.addUntrackedParameter<std::vector<double> >("thickness",layer.thickness);
+	    cfg.addUntrackedParameter<std::vector<std::string> >("interactionModels",std::vector<std::string>({"trackerSimHits","bremsstrahlung"}));
+	    return cfg;
+	}
+
+	// configuration of fastsim::Geometry, as TrackerMaterial_cfi.py
+	inline edm::ParameterSet syntheticGeometryConfig(double magneticFieldZ = 3.8,double maxRadius = 120.,double maxZ = 300.)
+	{
+	    std::vector<edm::ParameterSet> barrelLayers;
+	    for(const SyntheticLayer & layer : syntheticBarrelLayers())
+	    {
+		barrelLayers.push_back(syntheticLayerConfig(layer,false));
+	    }
+	    std::vector<edm::ParameterSet> forwardLayers;
+	    for(const SyntheticLayer & layer : syntheticForwardLayers())
+	    {
+		forwardLayers.push_back(syntheticLayerConfig(layer,true));
+	    }
+	    edm::ParameterSet cfg;
+	    cfg.addUntrackedParameter<double>("magneticFieldZ",magneticFieldZ);
+	    cfg.addUntrackedParameter<double>("maxRadius",maxRadius);
+	    cfg.addUntrackedParameter<double>("maxZ",maxZ);
+	    cfg.addUntrackedParameter<bool>("useTrackerRecoGeometryRecord",false);
+	    cfg.addParameter<std::vector<edm::ParameterSet> >("BarrelLayers",barrelLayers);
+	    cfg.addParameter<std::vector<edm::ParameterSet> >("ForwardLayers",forwardLayers);
+	    return cfg;
+	}
+
+	inline std::unique_ptr<Geometry> syntheticGeometry(const edm::ParameterSet & cfg = syntheticGeometryConfig())
+	{
+	    std::unique_ptr<Geometry> geometry(new Geometry(cfg));
+	    geometry->update(0,0);
+	    return geometry;
+	}
+    }
+}
+
+#endif
@@ -0,0 +1,52 @@
+// system include files
+#include <memory>
+#include <string>
+
+// framework
+#include "FWCore/Framework/interface/ESProducer.h"
+#include "FWCore/Framework/interface/ModuleFactory.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+// fastsim
+#include "FastSimulation/Geometry/interface/Geometry.h"
+#include "FastSimulation/Geometry/interface/FastSimGeometryRecord.h"
+
+// builds the fastsim::Geometry once per IOV
+// all streams of the FastSimProducer share the product read-only
+class FastSimGeometryESProducer : public edm::ESProducer
+{
+public:
+
+    FastSimGeometryESProducer(const edm::ParameterSet & iConfig);
+    ~FastSimGeometryESProducer(){;}
+
+    std::shared_ptr<fastsim::Geometry> produce(const FastSimGeometryRecord & iRecord);
+
+private:
+
+    const edm::ParameterSet detectorDefinition_;
+    static const std::string MESSAGECATEGORY;
+};
+
+const std::string FastSimGeometryESProducer::MESSAGECATEGORY = "FastSimulation";
+
+FastSimGeometryESProducer::FastSimGeometryESProducer(const edm::ParameterSet & iConfig)
+    : detectorDefinition_(iConfig.getParameter<edm::ParameterSet>("TrackerMaterial"))
+{
+    setWhatProduced(this);
+}
+
+std::shared_ptr<fastsim::Geometry>
+FastSimGeometryESProducer::produce(const FastSimGeometryRecord & iRecord)
+{
+    LogDebug(MESSAGECATEGORY) << "   building geometry";
+    // a new instance for every IOV:
+    // streams still holding the previous geometry are not affected
+    std::shared_ptr<fastsim::Geometry> geometry(new fastsim::Geometry(detectorDefinition_));
+    geometry->update(iRecord);
+    LogDebug(MESSAGECATEGORY) << *geometry;
+    return geometry;
+}
+
+DEFINE_FWK_EVENTSETUP_MODULE(FastSimGeometryESProducer);
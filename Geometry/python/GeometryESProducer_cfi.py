@@ -1,16 +1,11 @@
 import FWCore.ParameterSet.Config as cms
 
-# With an ideal geometry (for the reconstruction)
-from FastSimulation.TrackerSetup.TrackerMaterial_cfi import *
-GeometryESProducer = cms.ESProducer("GeometryESProducer",
-    TrackerMaterialBlock
-)
+from FastSimulation.Geometry.TrackerMaterial_cfi import TrackerMaterialBlock
 
-# The same as above but with a misaligned tracker geometry (for the simulation)
-misalignedGeometry = cms.ESProducer("GeometryESProducer",
+# fastsim::Geometry, built once per IOV and shared by all streams
+# the tracker alignment is set through TrackerMaterial.trackerAlignmentLabel
+fastSimGeometry = cms.ESProducer(
+    "FastSimGeometryESProducer",
     TrackerMaterialBlock,
-    trackerGeometryLabel = cms.untracked.string('MisAligned'),
-    appendToDataLabel = cms.string('MisAligned')
-)
-
-
+    appendToDataLabel = cms.string("")
+    )
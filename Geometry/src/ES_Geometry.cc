@@ -0,0 +1,4 @@
+#include "FastSimulation/Geometry/interface/Geometry.h"
+#include "FWCore/Utilities/interface/typelookup.h"
+
+TYPELOOKUP_DATA_REG(fastsim::Geometry);
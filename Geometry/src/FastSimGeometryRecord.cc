@@ -0,0 +1,4 @@
+#include "FastSimulation/Geometry/interface/FastSimGeometryRecord.h"
+#include "FWCore/Framework/interface/eventsetuprecord_registration_macro.h"
+
+EVENTSETUP_RECORD_REG(FastSimGeometryRecord);
@@ -14,9 +14,11 @@
 #include "MagneticField/UniformEngine/src/UniformMagneticField.h"
 #include "MagneticField/Records/interface/IdealMagneticFieldRecord.h"
 #include "FastSimulation/Geometry/interface/Geometry.h"
+#include "FastSimulation/Geometry/interface/FastSimGeometryRecord.h"
 
 #include <iostream>
 #include <map>
+#include <cmath>
 
 using namespace fastsim;
 
@@ -34,7 +36,7 @@ Geometry::Geometry(const edm::ParameterSet& cfg)
     , maxZ_(cfg.getUntrackedParameter<double>("maxZ",600.))
 {};
 
-void Geometry::update(const edm::EventSetup & iSetup,const std::map<std::string,fastsim::InteractionModel*> & interactionModelMap)
+void Geometry::update(const FastSimGeometryRecord & iRecord)
 {
 
     //----------------
@@ -44,10 +46,26 @@ void Geometry::update(const edm::EventSetup & iSetup,const std::map<std::string,
     if(useTrackerRecoGeometryRecord_)
     {
 	edm::ESHandle<GeometricSearchTracker> geometricSearchTrackerHandle;
-	iSetup.get<TrackerRecoGeometryRecord>().get(trackerAlignmentLabel_,geometricSearchTrackerHandle);
+	iRecord.getRecord<TrackerRecoGeometryRecord>().get(trackerAlignmentLabel_,geometricSearchTrackerHandle);
 	geometricSearchTracker = &(*geometricSearchTrackerHandle);
     }
 
+    //----------------
+    // find magnetic field
+    //----------------
+    const MagneticField * magneticField = 0;
+    if(!useFixedMagneticFieldZ_)
+    {
+	edm::ESHandle<MagneticField> magneticFieldHandle;
+	iRecord.getRecord<IdealMagneticFieldRecord>().get(magneticFieldHandle);
+	magneticField = &(*magneticFieldHandle);
+    }
+
+    update(geometricSearchTracker,magneticField);
+}
+
+void Geometry::update(const GeometricSearchTracker * geometricSearchTracker,const MagneticField * magneticField)
+{
     //----------------
     // update magnetic field
     //----------------
@@ -56,11 +74,14 @@ void Geometry::update(const edm::EventSetup & iSetup,const std::map<std::string,
 	ownedMagneticField_.reset(new UniformMagneticField(fixedMagneticFieldZ_));
 	magneticField_ = ownedMagneticField_.get();
     }
+    else if(magneticField)
+    {
+	ownedMagneticField_.reset();
+	magneticField_ = magneticField;
+    }
     else
     {
-	edm::ESHandle<MagneticField> magneticField;
-	iSetup.get<IdealMagneticFieldRecord>().get(magneticField);
-	magneticField_ = &(*magneticField);
+	throw cms::Exception("fastsim::Geometry") << "no magnetic field provided and no fixed magnetic field (magneticFieldZ) configured";
     }
 
     //---------------
@@ -68,13 +89,13 @@ void Geometry::update(const edm::EventSetup & iSetup,const std::map<std::string,
     //---------------
     fastsim::LayerFactory layerFactory(geometricSearchTracker
 				       ,*magneticField_
-				       ,interactionModelMap
 				       ,maxRadius_
 				       ,maxZ_);
     //---------------
     // update barrel layers
     //---------------
     barrelLayers_.clear();
+    barrelLayerRadii_.clear();
     for(const edm::ParameterSet & layerCfg : barrelLayerCfg_)
     {
 	barrelLayers_.push_back(layerFactory.createBarrelLayer(layerCfg));
@@ -83,6 +104,16 @@ void Geometry::update(const edm::EventSetup & iSetup,const std::map<std::string,
     {
 	// set index
 	barrelLayers_[index]->setIndex(index);
+	barrelLayerRadii_.push_back(barrelLayers_[index]->getRadius());
+	// check that the layer is inside the tracker volume (see LayerNavigator)
+	if(barrelLayers_[index]->getRadius() > maxRadius_ || barrelLayers_[index]->getMaterialLimit() > maxZ_)
+	{
+	    throw cms::Exception("fastsim::Geometry")
+		<< "barrel layers must be inside the tracker volume (maxRadius, maxZ)"
+		<< "\nbarrel layer " << index
+		<< " has radius " << barrelLayers_[index]->getRadius() << " and material up to |z| = " << barrelLayers_[index]->getMaterialLimit()
+		<< " (maxRadius: " << maxRadius_ << ", maxZ: " << maxZ_ << ")";
+	}
 	// check order
 	if(index > 0)
 	{
@@ -101,6 +132,7 @@ void Geometry::update(const edm::EventSetup & iSetup,const std::map<std::string,
     // update forward layers
     //--------------
     forwardLayers_.clear();
+    forwardLayerZ_.clear();
     for(const edm::ParameterSet & layerCfg : forwardLayerCfg_)
     {
 	forwardLayers_.push_back(layerFactory.createForwardLayer(fastsim::LayerFactory::POSFWD,layerCfg));
@@ -110,6 +142,16 @@ void Geometry::update(const edm::EventSetup & iSetup,const std::map<std::string,
     {
 	// set index
 	forwardLayers_[index]->setIndex(index);
+	forwardLayerZ_.push_back(forwardLayers_[index]->getZ());
+	// check that the layer is inside the tracker volume (see LayerNavigator)
+	if(std::abs(forwardLayers_[index]->getZ()) > maxZ_ || forwardLayers_[index]->getMaterialLimit() > maxRadius_)
+	{
+	    throw cms::Exception("fastsim::Geometry")
+		<< "forward layers must be inside the tracker volume (maxRadius, maxZ)"
+		<< "\nforward layer " << index
+		<< " has z " << forwardLayers_[index]->getZ() << " and material up to r = " << forwardLayers_[index]->getMaterialLimit()
+		<< " (maxRadius: " << maxRadius_ << ", maxZ: " << maxZ_ << ")";
+	}
 	// check order
 	if(index > 0)
 	{
@@ -137,13 +179,13 @@ std::ostream& fastsim::operator << (std::ostream& os , const fastsim::Geometry &
     for(const auto & layer : geometry.barrelLayers_)
     {
 	os << "\n   " << *layer
-	   << layer->getInteractionModels().size() << " interaction models";
+	   << layer->getInteractionModelLabels().size() << " interaction models";
     }
     os << "\n## ForwardLayers:";
     for(const auto & layer : geometry.forwardLayers_)
     {
 	os << "\n   " << *layer
-	   << layer->getInteractionModels().size() << " interaction models";
+	   << layer->getInteractionModelLabels().size() << " interaction models";
     }
     os << "\n-----------";
     return os;
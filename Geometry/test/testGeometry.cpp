@@ -0,0 +1,24 @@
+#include "FastSimulation/Geometry/interface/SyntheticGeometry.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <gtest/gtest.h>
+
+TEST(Geometry, TrackerMaterialLayersAreInsideTheTrackerVolume)
+{
+    // the outermost layers of TrackerMaterial_cfi.py are on the boundary of the volume
+    std::unique_ptr<fastsim::Geometry> geometry = fastsim::test::syntheticGeometry();
+    EXPECT_EQ(geometry->barrelLayers().size(),fastsim::test::syntheticBarrelLayers().size());
+    EXPECT_EQ(geometry->forwardLayers().size(),2*fastsim::test::syntheticForwardLayers().size());
+    EXPECT_DOUBLE_EQ(geometry->barrelLayers().back()->getRadius(),geometry->getMaxRadius());
+    EXPECT_DOUBLE_EQ(geometry->forwardLayers().back()->getZ(),geometry->getMaxZ());
+}
+
+TEST(Geometry, LayerOutsideTheTrackerVolumeThrows)
+{
+    // outermost barrel layer beyond maxRadius
+    fastsim::Geometry smallRadius(fastsim::test::syntheticGeometryConfig(3.8,110.,300.));
+    EXPECT_THROW(smallRadius.update(0,0),cms::Exception);
+    // barrel material (up to |z| = 299.9) and outermost forward layer beyond maxZ
+    fastsim::Geometry smallZ(fastsim::test::syntheticGeometryConfig(3.8,120.,250.));
+    EXPECT_THROW(smallZ.update(0,0),cms::Exception);
+}
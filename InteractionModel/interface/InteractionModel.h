@@ -11,7 +11,10 @@ namespace edm
     class ProducerBase;
 }
 
-class RandomEngineAndDistribution;
+namespace CLHEP
+{
+    class HepRandomEngine;
+}
 
 namespace fastsim
 {
@@ -23,9 +26,22 @@ namespace fastsim
 	InteractionModel(std::string name)
 	    : name_(name){}
 	virtual ~InteractionModel(){;}
-	virtual void interact(Particle & particle,const Layer & layer,std::vector<std::unique_ptr<Particle> > & secondaries,const RandomEngineAndDistribution & random) = 0;
+	virtual void interact(Particle & particle,const Layer & layer,std::vector<std::unique_ptr<Particle> > & secondaries,CLHEP::HepRandomEngine & random) = 0;
+
+	// classes of particles that interaction models may declare to (not) act on
+	enum ParticleClass {ELECTRON = 0, CHARGED = 1, NEUTRAL = 2, NPARTICLECLASSES = 3};
+	static ParticleClass particleClass(const Particle & particle);
+	// can the model act on particles of a given class on a given layer?
+	// used to skip layers on which none of the models can act on a particle (see LayerNavigator)
+	// default: yes. Only return false if interact(...) is guaranteed to do nothing.
+	virtual bool canAct(ParticleClass particleClass,const Layer & layer) const {return true;}
 	virtual void registerProducts(edm::ProducerBase & producer) const{;}
 	virtual void storeProducts(edm::Event & iEvent) {;}
+	// concurrent transport (see FastSimProducer): moves the products of another instance of the model (same configuration),
+	// which transported part of the event, to the end of the products of this one.
+	// simTrack indices of the other instance are shifted by simTrackIndexOffset.
+	// models that store products must implement it.
+	virtual void appendProducts(InteractionModel & other,int simTrackIndexOffset) {;}
 	const std::string getName(){return name_;}
  	friend std::ostream& operator << (std::ostream& o , const InteractionModel & model); 
    private:
@@ -18,7 +18,8 @@ namespace fastsim
     {
     public:
 	DummyHitProducer(const std::string & name,const edm::ParameterSet & cfg);
-	void interact(Particle & particle,const Layer & layer,std::vector<std::unique_ptr<Particle> > & secondaries,const RandomEngineAndDistribution & random) override;
+	void interact(Particle & particle,const Layer & layer,std::vector<std::unique_ptr<Particle> > & secondaries,CLHEP::HepRandomEngine & random) override;
+	bool canAct(ParticleClass particleClass,const Layer & layer) const override {return false;}
 	void registerProducts(edm::ProducerBase & producer) const override;
 	void storeProducts(edm::Event & iEvent) override;
     };
@@ -44,7 +45,7 @@ void fastsim::DummyHitProducer::registerProducts(edm::ProducerBase & producer) c
 void fastsim::DummyHitProducer::interact(Particle & particle,
 					       const fastsim::Layer & layer,
 					       std::vector<std::unique_ptr<Particle> > & secondaries,
-					       const RandomEngineAndDistribution & random)
+					       CLHEP::HepRandomEngine & random)
 {
     // I'm a dummy...
     return;
@@ -17,9 +17,10 @@ namespace fastsim
     {
     public:
 	SimpleLayerHitProducer(const std::string & name,const edm::ParameterSet & cfg);
-	void interact(Particle & particle,const Layer & layer,std::vector<std::unique_ptr<Particle> > & secondaries,const RandomEngineAndDistribution & random) override;
+	void interact(Particle & particle,const Layer & layer,std::vector<std::unique_ptr<Particle> > & secondaries,CLHEP::HepRandomEngine & random) override;
 	void registerProducts(edm::ProducerBase & producer) const override;
 	void storeProducts(edm::Event & iEvent) override;
+	void appendProducts(InteractionModel & other,int simTrackIndexOffset) override;
     private:
 	std::unique_ptr<std::vector<math::XYZTLorentzVector> > layerHits_;
     };
@@ -40,7 +41,7 @@ void fastsim::SimpleLayerHitProducer::registerProducts(edm::ProducerBase & produ
 void fastsim::SimpleLayerHitProducer::interact(Particle & particle,
 					       const fastsim::Layer & layer,
 					       std::vector<std::unique_ptr<Particle> > & secondaries,
-					       const RandomEngineAndDistribution & random)
+					       CLHEP::HepRandomEngine & random)
 {
     if(layer.isOnSurface(particle.position()))
     {
@@ -56,6 +57,14 @@ void fastsim::SimpleLayerHitProducer::storeProducts(edm::Event & iEvent)
     layerHits_.reset(new std::vector<math::XYZTLorentzVector>());
 }
 
+void fastsim::SimpleLayerHitProducer::appendProducts(InteractionModel & other,int simTrackIndexOffset)
+{
+    // (the hits do not refer to simTracks)
+    std::vector<math::XYZTLorentzVector> & otherLayerHits = *static_cast<SimpleLayerHitProducer &>(other).layerHits_;
+    layerHits_->insert(layerHits_->end(),otherLayerHits.begin(),otherLayerHits.end());
+    otherLayerHits.clear();
+}
+
 DEFINE_EDM_PLUGIN(
     fastsim::InteractionModelFactory,
     fastsim::SimpleLayerHitProducer,
@@ -1,4 +1,16 @@
 #include "FastSimulation/InteractionModel/interface/InteractionModel.h"
+#include "FastSimulation/NewParticle/interface/Particle.h"
+
+#include <cstdlib>
+
+fastsim::InteractionModel::ParticleClass fastsim::InteractionModel::particleClass(const fastsim::Particle & particle)
+{
+    if(std::abs(particle.pdgId()) == 11)
+    {
+	return ELECTRON;
+    }
+    return particle.charge() != 0 ? CHARGED : NEUTRAL;
+}
 
 std::ostream & fastsim::operator << (std::ostream& os , const fastsim::InteractionModel & interactionModel)
 {
@@ -4,7 +4,6 @@
 #include "FastSimulation/Layer/interface/Layer.h"
 #include "DataFormats/GeometryVector/interface/GlobalPoint.h"
 #include "FWCore/Utilities/interface/Exception.h"
-#include "TH1F.h"
 
 namespace fastsim{
 
@@ -27,7 +26,7 @@ namespace fastsim{
 		throw cms::Exception("fastsim::BarrelLayer::getThickness") << "position is not on layer's surface";
 	    }
 	    double fabsCosTheta = fabs(momentum.Vect().Dot(position.Vect())) / momentum.Rho() / position.Rho();
-	    return thicknessHist_->GetBinContent(thicknessHist_->GetXaxis()->FindBin(fabs(position.Z()))) / fabsCosTheta;
+	    return thicknessTable_.value(fabs(position.Z())) / fabsCosTheta;
 	}
 	
 	const double getMagneticFieldZ(const math::XYZTLorentzVector & position) const override
@@ -36,7 +35,7 @@ namespace fastsim{
 	    {
 		throw cms::Exception("fastsim::BarrelLayer::getMagneticFieldZ") << "position is not on layer's surface";
 	    }
-	    return magneticFieldHist_->GetBinContent(magneticFieldHist_->GetXaxis()->FindBin(fabs(position.z())));
+	    return magneticFieldTable_.value(fabs(position.z()));
 	}
 
 	bool isForward() const override 
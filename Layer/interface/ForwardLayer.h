@@ -3,7 +3,6 @@
 
 #include "FastSimulation/Layer/interface/Layer.h"
 #include "DataFormats/Math/interface/LorentzVector.h"
-#include "TH1F.h"
 #include "FWCore/Utilities/interface/Exception.h"
 
 
@@ -25,7 +24,7 @@ namespace fastsim{
 	    {
 		return 0;
 	    }
-	    return thicknessHist_->GetBinContent(thicknessHist_->GetXaxis()->FindBin(fabs(position.Pt()))) / fabs(momentum.Pz()) * momentum.P();
+	    return thicknessTable_.value(fabs(position.Pt())) / fabs(momentum.Pz()) * momentum.P();
 	}
 
 	const double getMagneticFieldZ(const math::XYZTLorentzVector & position) const override
@@ -34,7 +33,7 @@ namespace fastsim{
 	    {
 		throw cms::Exception("fastsim::BarrelLayer::getMagneticFieldZ") << "position is not on layer's surface";
 	    }
-	    return magneticFieldHist_->GetBinContent(magneticFieldHist_->GetXaxis()->FindBin(position.Pt()));
+	    return magneticFieldTable_.value(position.Pt());
 	}
 	
 	bool isForward() const override {return true;}
@@ -2,14 +2,15 @@
 #define FASTSIM_LAYER_H
 
 #include "DataFormats/Math/interface/LorentzVector.h"
+#include "FastSimulation/Layer/interface/LookupTable.h"
 
 #include <memory>
+#include <string>
 #include <vector>
 
 class DetLayer;
 class MagneticField;
 class GeometricSearchTracker;
-class TH1F;
 
 namespace edm
 {
@@ -18,8 +19,8 @@ namespace edm
 
 namespace fastsim
 {
-    class InteractionModel;
     class LayerFactory;
+    class ModuleIndex;
     class Layer
     {
     public:
@@ -37,34 +38,42 @@ namespace fastsim
 	int index() const {return index_;}
 	virtual const double getThickness(const math::XYZTLorentzVector & position, const math::XYZTLorentzVector & momentum) const = 0;
 	const double getNuclearInteractionThicknessFactor() const {return nuclearInteractionThicknessFactor_; }
+	// the material extends up to this |z| (barrel layers) or r (forward layers)
+	const double getMaterialLimit() const {return thicknessTable_.highEdge();}
 	const DetLayer* getDetLayer(double z = 0) const { return detLayer_; }
+	// spatial index of the modules of the DetLayer, 0 if there is no DetLayer
+	const ModuleIndex * getModuleIndex() const { return moduleIndex_.get(); }
 	virtual const double getMagneticFieldZ(const math::XYZTLorentzVector & position) const = 0;
 	virtual bool isForward() const = 0;
 
 	virtual bool isOnSurface(const math::XYZTLorentzVector & position) const = 0;
 
-	const std::vector<InteractionModel *> & getInteractionModels() const
+	// labels of the interaction models to be applied on this layer
+	// (the models themselves are owned by the producer, see FastSimProducer)
+	const std::vector<std::string> & getInteractionModelLabels() const
 	{
-	    return interactionModels_;
+	    return interactionModelLabels_;
 	}
 
 	// friends
 	friend std::ostream& operator << (std::ostream& os , const Layer & layer);
 	friend class fastsim::LayerFactory;
 
+	// tolerances of isOnSurface
+	static constexpr double epsilonDistanceZ_ = 1.0e-5;
+	static constexpr double epsilonDistanceR_ = 1.0e-3;
+
     protected:
 	
 	double position_;
 	double position2_;
 	int index_;
 	const DetLayer * detLayer_;
-	std::unique_ptr<TH1F> magneticFieldHist_;
-	std::unique_ptr<TH1F> thicknessHist_;
+	std::unique_ptr<const ModuleIndex> moduleIndex_;
+	LookupTable magneticFieldTable_;
+	LookupTable thicknessTable_;
 	double nuclearInteractionThicknessFactor_;
-	std::vector<InteractionModel *> interactionModels_;
-	
-	static constexpr double epsilonDistanceZ_ = 1.0e-5;
-	static constexpr double epsilonDistanceR_ = 1.0e-3;
+	std::vector<std::string> interactionModelLabels_;
     };
 
     std::ostream& operator << (std::ostream& os , const Layer & layer);
@@ -22,14 +22,12 @@ namespace fastsim
     class Layer;
     class BarrelLayer;
     class ForwardLayer;
-    class InteractionModel;
     class LayerFactory
     {
     public:
 
 	LayerFactory(const GeometricSearchTracker * geometricSearchTracker,
 		     const MagneticField & magneticField,
-		     const std::map<std::string,fastsim::InteractionModel *> & interactionModelMap,
 		     double magneticFieldHistMaxR,
 		     double magneticFieldHistMaxZ);
 	
@@ -47,7 +45,6 @@ namespace fastsim
 	const DetLayer * getDetLayer(const std::string & detLayerName,const GeometricSearchTracker & geometricSearchTracker) const;
 	const GeometricSearchTracker * const geometricSearchTracker_;
 	const MagneticField * const magneticField_;
-	const std::map<std::string,fastsim::InteractionModel *> * interactionModelMap_;
 	const double magneticFieldHistMaxR_;
 	const double magneticFieldHistMaxZ_;
 	std::map<std::string,const std::vector<BarrelDetLayer const *> *> barrelDetLayersMap_;
@@ -0,0 +1,72 @@
+#ifndef FASTSIM_LOOKUPTABLE_H
+#define FASTSIM_LOOKUPTABLE_H
+
+#include <vector>
+
+namespace fastsim
+{
+    // piecewise constant function of one variable,
+    // with the binning conventions of a ROOT histogram (TAxis::FindFixBin):
+    //    bin i covers [edge_(i-1), edge_i)
+    //    values below the first edge return the underflow value
+    //    values above or on the last edge (and NaN) return the overflow value
+    // tables with equidistant bins (as TH1F(name,title,nBins,low,high)) compute the bin directly,
+    // with the same rounding as ROOT, tables with variable edges use a binary search
+    class LookupTable
+    {
+    public:
+	LookupTable();
+
+	// nBins equidistant bins between low and high, values.size() must be equal to nBins
+	LookupTable(unsigned nBins,
+		    double low,
+		    double high,
+		    const std::vector<double> & values,
+		    double underflow = 0.,
+		    double overflow = 0.);
+
+	// values.size() must be equal to edges.size() - 1
+	LookupTable(const std::vector<double> & edges,
+		    const std::vector<double> & values,
+		    double underflow = 0.,
+		    double overflow = 0.);
+
+	double value(double x) const
+	{
+	    return values_[findBin(x)];
+	}
+
+	unsigned nBins() const {return edges_.size() - 1;}
+	double lowEdge() const {return edges_.front();}
+	double highEdge() const {return edges_.back();}
+	bool isUniform() const {return isUniform_;}
+
+    private:
+	// 0 for underflow, nBins()+1 for overflow
+	unsigned findBin(double x) const
+	{
+	    if(x < edges_.front())
+	    {
+		return 0;
+	    }
+	    if(!(x < edges_.back()))
+	    {
+		return edges_.size();
+	    }
+	    if(isUniform_)
+	    {
+		// same expression as TAxis::FindFixBin: close to the edges, the bin follows the rounding of ROOT
+		return 1 + unsigned((edges_.size() - 1) * (x - edges_.front()) / (edges_.back() - edges_.front()));
+	    }
+	    return findBinBinarySearch(x);
+	}
+
+	unsigned findBinBinarySearch(double x) const;
+
+	std::vector<double> edges_;
+	std::vector<double> values_;   // including underflow and overflow
+	bool isUniform_;
+    };
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef FASTSIM_MODULEINDEX_H
+#define FASTSIM_MODULEINDEX_H
+
+#include <vector>
+
+class DetLayer;
+class GeomDet;
+
+namespace fastsim
+{
+    // spatial index of the tracker modules of a DetLayer
+    //    - the modules are the GeomDets without components (i.e. the mono and stereo modules of glued dets)
+    //    - the bounds of each module are projected to (phi,u), with u = z for barrel layers and u = r for forward layers,
+    //      and registered in a regular grid in (phi,u), with cells of about the size of a module
+    //    - the modules that overlap a window in (phi,u) are found by visiting the few cells that the window covers
+    // the extent of the modules in the coordinate w perpendicular to the layer (w = r for barrel layers, w = z for forward layers)
+    // is available as well, to build the window from the trajectory of a particle
+    // module properties are stored as a structure of arrays
+    class ModuleIndex
+    {
+    public:
+	// module planes, by module index
+	struct Planes
+	{
+	    // origin
+	    std::vector<double> x, y, z;
+	    // rotation: local = R * (global - origin), row i is the local axis i in global coordinates
+	    std::vector<double> rxx, rxy, rxz;
+	    std::vector<double> ryx, ryy, ryz;
+	    std::vector<double> rzx, rzy, rzz;
+	    std::vector<double> halfWidth, halfLength, halfThickness;
+	    // trapezoidal modules (TID, TEC): the half width at local y is halfWidth * (1 - y * trapezoid)
+	    // (trapezoid = 1 / r of the origin), 0 for rectangular modules
+	    std::vector<double> trapezoid;
+	};
+
+	ModuleIndex(const DetLayer & detLayer,bool isForward);
+	// index of the given modules (GeomDets without components), e.g. for tests
+	ModuleIndex(const std::vector<const GeomDet *> & modules,bool isForward);
+
+	unsigned size() const {return modules_.size();}
+	const GeomDet & module(unsigned index) const {return *modules_[index];}
+	const Planes & planes() const {return planes_;}
+
+	double minW() const {return minW_;}
+	double maxW() const {return maxW_;}
+
+	// append the indices of the modules that overlap [phiMin,phiMax] x [uMin,uMax]
+	// (in increasing order, without duplicates, phiMin and phiMax may be outside [-pi,pi])
+	void candidates(double phiMin,double phiMax,double uMin,double uMax,std::vector<unsigned> & indices) const;
+
+    private:
+	void addModule(const GeomDet & module,bool isForward);
+	int phiBin(double phi) const;
+	int uBin(double u) const;
+
+	// modules and their bounds in (phi,u)
+	std::vector<const GeomDet *> modules_;
+	std::vector<float> phiMin_;
+	std::vector<float> phiMax_;
+	std::vector<float> uMin_;
+	std::vector<float> uMax_;
+	Planes planes_;
+	double minW_;
+	double maxW_;
+
+	// grid: modules of cell (phiBin,uBin) are cellModules_[cellStart_[c]] ... cellModules_[cellStart_[c+1]-1]
+	// with c = phiBin * nU_ + uBin
+	int nPhi_;
+	int nU_;
+	double phiBinWidth_;
+	double uLow_;
+	double uBinWidth_;
+	std::vector<unsigned> cellStart_;
+	std::vector<unsigned> cellModules_;
+    };
+}
+
+#endif
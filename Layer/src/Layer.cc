@@ -1,6 +1,6 @@
 #include "FastSimulation/Layer/interface/Layer.h"
+#include "FastSimulation/Layer/interface/ModuleIndex.h"
 #include "iostream"
-#include "TH1F.h"
 
 std::ostream& fastsim::operator << (std::ostream& os , const Layer & layer)
 {
@@ -10,9 +10,6 @@ std::ostream& fastsim::operator << (std::ostream& os , const Layer & layer)
     return os;
 }
 
-// note: define destructor and constructor in .cc file,
-//       otherwise one cannot forward declare TH1F in the header file
-//       w/o compilation issues
 fastsim::Layer::~Layer()
 {}
 
@@ -4,36 +4,38 @@
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 #include "FastSimulation/Layer/interface/BarrelLayer.h"
 #include "FastSimulation/Layer/interface/ForwardLayer.h"
+#include "FastSimulation/Layer/interface/ModuleIndex.h"
 #include "RecoTracker/TkDetLayers/interface/GeometricSearchTracker.h"
 #include "MagneticField/Engine/interface/MagneticField.h"
 
-#include "TH1F.h"
 #include "ctype.h"
 
 
 fastsim::LayerFactory::LayerFactory(const GeometricSearchTracker * geometricSearchTracker,
 				    const MagneticField & magneticField,
-				    const std::map<std::string,fastsim::InteractionModel *> & interactionModelMap,
 				    double magneticFieldHistMaxR,
 				    double magneticFieldHistMaxZ)
     : geometricSearchTracker_(geometricSearchTracker)
     , magneticField_(&magneticField)
-    , interactionModelMap_(&interactionModelMap)
     , magneticFieldHistMaxR_(magneticFieldHistMaxR)
     , magneticFieldHistMaxZ_(magneticFieldHistMaxZ)
 {
-    // naming convention for barrel DetLayer lists
-    barrelDetLayersMap_["BPix"] = &geometricSearchTracker_->pixelBarrelLayers();
-    barrelDetLayersMap_["TIB"] = &geometricSearchTracker_->tibLayers();
-    barrelDetLayersMap_["TOB"] = &geometricSearchTracker_->tobLayers();
+    // without tracker geometry (see Geometry::update), layers are built without DetLayer
+    if(geometricSearchTracker_)
+    {
+	// naming convention for barrel DetLayer lists
+	barrelDetLayersMap_["BPix"] = &geometricSearchTracker_->pixelBarrelLayers();
+	barrelDetLayersMap_["TIB"] = &geometricSearchTracker_->tibLayers();
+	barrelDetLayersMap_["TOB"] = &geometricSearchTracker_->tobLayers();
 
-    // naming convention for forwardd DetLayer lists
-    forwardDetLayersMap_["negFPix"] = &geometricSearchTracker_->negPixelForwardLayers();
-    forwardDetLayersMap_["posFPix"] = &geometricSearchTracker_->posPixelForwardLayers();
-    forwardDetLayersMap_["negTID"] = &geometricSearchTracker_->negTidLayers();
-    forwardDetLayersMap_["posTID"] = &geometricSearchTracker_->posTidLayers();
-    forwardDetLayersMap_["negTEC"] = &geometricSearchTracker_->negTecLayers();
-    forwardDetLayersMap_["posTEC"] = &geometricSearchTracker_->posTecLayers();
+	// naming convention for forwardd DetLayer lists
+	forwardDetLayersMap_["negFPix"] = &geometricSearchTracker_->negPixelForwardLayers();
+	forwardDetLayersMap_["posFPix"] = &geometricSearchTracker_->posPixelForwardLayers();
+	forwardDetLayersMap_["negTID"] = &geometricSearchTracker_->negTidLayers();
+	forwardDetLayersMap_["posTID"] = &geometricSearchTracker_->posTidLayers();
+	forwardDetLayersMap_["negTEC"] = &geometricSearchTracker_->negTecLayers();
+	forwardDetLayersMap_["posTEC"] = &geometricSearchTracker_->posTecLayers();
+    }
 }
 
 std::unique_ptr<fastsim::BarrelLayer> fastsim::LayerFactory::createBarrelLayer(const edm::ParameterSet & cfg) const
@@ -137,9 +139,13 @@ std::unique_ptr<fastsim::Layer> fastsim::LayerFactory::createLayer(const fastsim
 	layer.reset(new fastsim::BarrelLayer(position));
     }
     layer->detLayer_ = detLayer;
+    if(detLayer)
+    {
+	layer->moduleIndex_.reset(new fastsim::ModuleIndex(*detLayer,isForward));
+    }
 
     // -----------------------------
-    // thickness histogram
+    // thickness table
     // -----------------------------
 
     // Get limits
@@ -167,12 +173,8 @@ std::unique_ptr<fastsim::Layer> fastsim::LayerFactory::createLayer(const fastsim
 	    << "layer thickness and limits not configured properly! error in:"
 	    << cfgString;
     }
-    // create the histogram
-    layer->thicknessHist_.reset(new TH1F("h", "h", limits.size()-1, &limits[0]));
-    layer->thicknessHist_->SetDirectory(0);
-    for(unsigned i = 1; i < limits.size(); ++i){
-	layer->thicknessHist_->SetBinContent(i, thickness[i-1]);
-    }
+    // create the table (no material outside the limits)
+    layer->thicknessTable_ = fastsim::LookupTable(limits,thickness);
     
     // -----------------------------
     // nuclear interaction thickness factor
@@ -184,30 +186,31 @@ std::unique_ptr<fastsim::Layer> fastsim::LayerFactory::createLayer(const fastsim
     // magnetic field
     // -----------------------------
     
-    layer->magneticFieldHist_.reset(new TH1F("h", "h", 100, 0., isForward ? magneticFieldHistMaxR_ : magneticFieldHistMaxZ_));
-    layer->magneticFieldHist_->SetDirectory(0);
-    for(int i = 1; i <= 101; i++)
+    // 100 equidistant bins in z (barrel) or r (forward),
+    // filled with the field at the bin centers
+    // beyond the range the field at the center of the next (virtual) bin is used
+    const unsigned nFieldBins = 100;
+    const double fieldRange = isForward ? magneticFieldHistMaxR_ : magneticFieldHistMaxZ_;
+    std::vector<double> fieldValues(nFieldBins + 1);
+    for(unsigned i = 0; i <= nFieldBins; i++)
     {
+	double binCenter = fieldRange * (i + 0.5) / nFieldBins;
 	GlobalPoint point = isForward ? 
-	    GlobalPoint(layer->magneticFieldHist_->GetXaxis()->GetBinCenter(i), 0.,position)
-	    : GlobalPoint(position, 0.,layer->magneticFieldHist_->GetXaxis()->GetBinCenter(i));
-	layer->magneticFieldHist_->SetBinContent(i, magneticField_->inTesla(point).z());
+	    GlobalPoint(binCenter, 0.,position)
+	    : GlobalPoint(position, 0.,binCenter);
+	fieldValues[i] = magneticField_->inTesla(point).z();
     }
+    double fieldOverflow = fieldValues.back();
+    fieldValues.pop_back();
+    layer->magneticFieldTable_ = fastsim::LookupTable(nFieldBins,0.,fieldRange,fieldValues,0.,fieldOverflow);
     
     // -----------------------------
     // list of interaction models
     // -----------------------------
 
-    std::vector<std::string> interactionModelLabels = cfg.getUntrackedParameter<std::vector<std::string> >("interactionModels");
-    for(const auto & label : interactionModelLabels)
-    {
-    	std::map<std::string,fastsim::InteractionModel *>::const_iterator interactionModel = interactionModelMap_->find(label);
-    	if(interactionModel == interactionModelMap_->end())
-    	{
-    	    throw cms::Exception("fastsim::LayerFactory") << "unknown interaction model '" << label << "'";
-    	}
-    	layer->interactionModels_.push_back(interactionModel->second);
-    }
+    // only the labels are stored:
+    // the geometry is shared by all streams, while each stream owns its interaction models
+    layer->interactionModelLabels_ = cfg.getUntrackedParameter<std::vector<std::string> >("interactionModels");
 
     // -----------------------------
     // and return the layer!
@@ -0,0 +1,76 @@
+#include "FastSimulation/Layer/interface/LookupTable.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <algorithm>
+
+fastsim::LookupTable::LookupTable()
+    : edges_(2,0.)
+    , values_(3,0.)
+    , isUniform_(false)
+{}
+
+fastsim::LookupTable::LookupTable(unsigned nBins,
+				  double low,
+				  double high,
+				  const std::vector<double> & values,
+				  double underflow,
+				  double overflow)
+    : isUniform_(true)
+{
+    if(nBins == 0 || values.size() != nBins)
+    {
+	throw cms::Exception("fastsim::LookupTable") << "need " << nBins << " values for " << nBins << " bins, got " << values.size() << " values";
+    }
+    if(!(high > low))
+    {
+	throw cms::Exception("fastsim::LookupTable") << "upper edge " << high << " must be above lower edge " << low;
+    }
+
+    // edges as in TAxis::GetBinLowEdge
+    double binWidth = (high - low) / nBins;
+    edges_.reserve(nBins + 1);
+    for(unsigned index = 0;index < nBins;index++)
+    {
+	edges_.push_back(low + index * binWidth);
+    }
+    edges_.push_back(high);
+
+    values_.reserve(nBins + 2);
+    values_.push_back(underflow);
+    values_.insert(values_.end(),values.begin(),values.end());
+    values_.push_back(overflow);
+}
+
+fastsim::LookupTable::LookupTable(const std::vector<double> & edges,
+				  const std::vector<double> & values,
+				  double underflow,
+				  double overflow)
+    : edges_(edges)
+    , isUniform_(false)
+{
+    if(edges_.size() < 2 || values.size() != edges_.size() - 1)
+    {
+	throw cms::Exception("fastsim::LookupTable") << "need n+1 edges for n values, got " << edges_.size() << " edges and " << values.size() << " values";
+    }
+    for(unsigned index = 1;index < edges_.size();index++)
+    {
+	if(edges_[index] < edges_[index-1])
+	{
+	    throw cms::Exception("fastsim::LookupTable") << "edges must be provided in increasing order";
+	}
+    }
+
+    values_.reserve(values.size() + 2);
+    values_.push_back(underflow);
+    values_.insert(values_.end(),values.begin(),values.end());
+    values_.push_back(overflow);
+}
+
+unsigned fastsim::LookupTable::findBinBinarySearch(double x) const
+{
+    // as TMath::BinarySearch in TAxis::FindFixBin:
+    // the bin of the last edge <= x, on an edge shared by a bin of zero width that bin is returned
+    std::vector<double>::const_iterator edge = std::lower_bound(edges_.begin(),edges_.end(),x);
+    return (edge - edges_.begin()) + (*edge == x ? 1 : 0);
+}
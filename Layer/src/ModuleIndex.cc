@@ -0,0 +1,245 @@
+#include "FastSimulation/Layer/interface/ModuleIndex.h"
+
+#include "TrackingTools/DetLayers/interface/DetLayer.h"
+#include "Geometry/CommonDetUnit/interface/GeomDet.h"
+#include "DataFormats/GeometrySurface/interface/Plane.h"
+#include "DataFormats/GeometryVector/interface/GlobalPoint.h"
+#include "DataFormats/GeometryVector/interface/LocalPoint.h"
+#include "DataFormats/GeometryVector/interface/GlobalVector.h"
+#include "DataFormats/GeometryVector/interface/LocalVector.h"
+#include "DataFormats/Math/interface/deltaPhi.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // cells per average module size: a module overlaps about 2 x 2 cells
+    const double cellsPerModule = 1.;
+    const int maxBins = 512;
+
+    // phi shifted by a multiple of 2 pi, to be as close as possible to reference
+    double closestPhi(double phi,double reference)
+    {
+	return phi + 2.*M_PI*std::round((reference - phi)/(2.*M_PI));
+    }
+
+    // the modules of a layer: its basic components, or their components for glued dets
+    std::vector<const GeomDet *> leafModules(const DetLayer & detLayer)
+    {
+	std::vector<const GeomDet *> modules;
+	for(const GeomDet * det : detLayer.basicComponents())
+	{
+	    if(det->isLeaf())
+	    {
+		modules.push_back(det);
+	    }
+	    else
+	    {
+		for(const GeomDet * component : det->components())
+		{
+		    modules.push_back(component);
+		}
+	    }
+	}
+	return modules;
+    }
+}
+
+fastsim::ModuleIndex::ModuleIndex(const DetLayer & detLayer,bool isForward)
+    : ModuleIndex(leafModules(detLayer),isForward)
+{;}
+
+fastsim::ModuleIndex::ModuleIndex(const std::vector<const GeomDet *> & modules,bool isForward)
+    : minW_(0)
+    , maxW_(0)
+    , nPhi_(1)
+    , nU_(1)
+    , phiBinWidth_(2.*M_PI)
+    , uLow_(0)
+    , uBinWidth_(1)
+{
+    for(const GeomDet * module : modules)
+    {
+	addModule(*module,isForward);
+    }
+    if(modules_.empty())
+    {
+	cellStart_.assign(2,0);
+	return;
+    }
+
+    //
+    // grid binning, from the average size of the modules
+    //
+    double phiSize = 0;
+    double uSize = 0;
+    uLow_ = uMin_[0];
+    double uHigh = uMax_[0];
+    for(unsigned index = 0;index < size();++index)
+    {
+	phiSize += phiMax_[index] - phiMin_[index];
+	uSize += uMax_[index] - uMin_[index];
+	uLow_ = std::min<double>(uLow_,uMin_[index]);
+	uHigh = std::max<double>(uHigh,uMax_[index]);
+    }
+    phiSize /= size();
+    uSize /= size();
+    nPhi_ = std::max(1,std::min(maxBins,int(std::ceil(2.*M_PI / phiSize * cellsPerModule))));
+    nU_ = std::max(1,std::min(maxBins,int(std::ceil((uHigh - uLow_) / uSize * cellsPerModule))));
+    phiBinWidth_ = 2.*M_PI / nPhi_;
+    uBinWidth_ = uHigh > uLow_ ? (uHigh - uLow_) / nU_ : 1.;
+
+    //
+    // register the modules in the cells they overlap (counting sort)
+    //
+    std::vector<unsigned> count(nPhi_*nU_ + 1,0);
+    for(int pass = 0;pass < 2;++pass)
+    {
+	for(unsigned index = 0;index < size();++index)
+	{
+	    int phiFirst = phiBin(phiMin_[index]);
+	    int phiLast = std::min(phiBin(phiMax_[index]),phiFirst + nPhi_ - 1);
+	    int uFirst = uBin(uMin_[index]);
+	    int uLast = uBin(uMax_[index]);
+	    for(int phiIndex = phiFirst;phiIndex <= phiLast;++phiIndex)
+	    {
+		int phiCell = ((phiIndex % nPhi_) + nPhi_) % nPhi_;
+		for(int uIndex = uFirst;uIndex <= uLast;++uIndex)
+		{
+		    unsigned cell = phiCell*nU_ + uIndex;
+		    if(pass == 0)
+		    {
+			++count[cell + 1];
+		    }
+		    else
+		    {
+			cellModules_[count[cell]++] = index;
+		    }
+		}
+	    }
+	}
+	if(pass == 0)
+	{
+	    for(unsigned cell = 1;cell < count.size();++cell)
+	    {
+		count[cell] += count[cell - 1];
+	    }
+	    cellStart_ = count;
+	    cellModules_.resize(count.back());
+	}
+    }
+}
+
+void fastsim::ModuleIndex::addModule(const GeomDet & module,bool isForward)
+{
+    const Plane & surface = module.surface();
+    float halfWidth = surface.bounds().width()/2.;
+    float halfLength = surface.bounds().length()/2.;
+    float halfThickness = surface.bounds().thickness()/2.;
+    double phiCenter = surface.position().phi();
+
+    // extent of the eight corners of the module
+    double phiMin = 0, phiMax = 0, uMin = 0, uMax = 0, wMin = 0, wMax = 0;
+    for(int corner = 0;corner < 8;++corner)
+    {
+	GlobalPoint point = surface.toGlobal(LocalPoint((corner & 1 ? 1 : -1)*halfWidth,
+							(corner & 2 ? 1 : -1)*halfLength,
+							(corner & 4 ? 1 : -1)*halfThickness));
+	double phi = reco::deltaPhi(double(point.phi()),phiCenter);
+	double u = isForward ? point.perp() : point.z();
+	double w = isForward ? point.z() : point.perp();
+	if(corner == 0)
+	{
+	    phiMin = phiMax = phi;
+	    uMin = uMax = u;
+	    wMin = wMax = w;
+	}
+	phiMin = std::min(phiMin,phi);
+	phiMax = std::max(phiMax,phi);
+	uMin = std::min(uMin,u);
+	uMax = std::max(uMax,u);
+	wMin = std::min(wMin,w);
+	wMax = std::max(wMax,w);
+    }
+
+    if(modules_.empty())
+    {
+	minW_ = wMin;
+	maxW_ = wMax;
+    }
+    minW_ = std::min(minW_,wMin);
+    maxW_ = std::max(maxW_,wMax);
+
+    modules_.push_back(&module);
+    phiMin_.push_back(phiCenter + phiMin);
+    phiMax_.push_back(phiCenter + phiMax);
+    uMin_.push_back(uMin);
+    uMax_.push_back(uMax);
+
+    // plane of the module: column j of the rotation is the global unit vector j in local coordinates
+    LocalVector column[3] = {surface.toLocal(GlobalVector(1,0,0)),surface.toLocal(GlobalVector(0,1,0)),surface.toLocal(GlobalVector(0,0,1))};
+    planes_.x.push_back(surface.position().x());
+    planes_.y.push_back(surface.position().y());
+    planes_.z.push_back(surface.position().z());
+    planes_.rxx.push_back(column[0].x());
+    planes_.rxy.push_back(column[1].x());
+    planes_.rxz.push_back(column[2].x());
+    planes_.ryx.push_back(column[0].y());
+    planes_.ryy.push_back(column[1].y());
+    planes_.ryz.push_back(column[2].y());
+    planes_.rzx.push_back(column[0].z());
+    planes_.rzy.push_back(column[1].z());
+    planes_.rzz.push_back(column[2].z());
+    planes_.halfWidth.push_back(halfWidth);
+    planes_.halfLength.push_back(halfLength);
+    planes_.halfThickness.push_back(halfThickness);
+    unsigned subdet = module.geographicalId().subdetId();
+    planes_.trapezoid.push_back(subdet == 4 || subdet == 6 ? 1./surface.position().perp() : 0.);
+}
+
+int fastsim::ModuleIndex::phiBin(double phi) const
+{
+    return int(std::floor((phi + M_PI) / phiBinWidth_));
+}
+
+int fastsim::ModuleIndex::uBin(double u) const
+{
+    return std::max(0,std::min(nU_ - 1,int(std::floor((u - uLow_) / uBinWidth_))));
+}
+
+void fastsim::ModuleIndex::candidates(double phiMin,double phiMax,double uMin,double uMax,std::vector<unsigned> & indices) const
+{
+    if(modules_.empty() || uMax < uLow_ || uMin > uLow_ + nU_*uBinWidth_)
+    {
+	return;
+    }
+
+    unsigned first = indices.size();
+    int phiFirst = phiBin(phiMin);
+    int phiLast = std::min(phiBin(phiMax),phiFirst + nPhi_ - 1);
+    int uFirst = uBin(uMin);
+    int uLast = uBin(uMax);
+    double phiCenter = (phiMin + phiMax) / 2.;
+    for(int phiIndex = phiFirst;phiIndex <= phiLast;++phiIndex)
+    {
+	int phiCell = ((phiIndex % nPhi_) + nPhi_) % nPhi_;
+	for(int uIndex = uFirst;uIndex <= uLast;++uIndex)
+	{
+	    unsigned cell = phiCell*nU_ + uIndex;
+	    for(unsigned entry = cellStart_[cell];entry < cellStart_[cell + 1];++entry)
+	    {
+		unsigned index = cellModules_[entry];
+		// the cells are coarse: check the bounds of the module itself
+		double shift = closestPhi(phiMin_[index],phiCenter) - phiMin_[index];
+		if(uMax_[index] >= uMin && uMin_[index] <= uMax
+		   && phiMax_[index] + shift >= phiMin && phiMin_[index] + shift <= phiMax)
+		{
+		    indices.push_back(index);
+		}
+	    }
+	}
+    }
+    std::sort(indices.begin() + first,indices.end());
+    indices.erase(std::unique(indices.begin() + first,indices.end()),indices.end());
+}
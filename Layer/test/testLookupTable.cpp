@@ -0,0 +1,218 @@
+#include "FastSimulation/Layer/interface/LookupTable.h"
+#include "FastSimulation/Layer/interface/LayerFactory.h"
+#include "FastSimulation/Layer/interface/BarrelLayer.h"
+#include "FastSimulation/Layer/interface/ForwardLayer.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/Exception.h"
+#include "MagneticField/Engine/interface/MagneticField.h"
+
+#include "TH1F.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+// the lookup tables of the layers replace histograms (TH1F) that were looked up with TAxis::FindBin:
+// the tables are compared to such histograms, on and next to the bin edges and outside the range
+namespace
+{
+    // field that changes in r and z, such that every bin has a different value
+    class TestMagneticField : public MagneticField
+    {
+    public:
+	GlobalVector inTesla(const GlobalPoint & point) const override
+	{
+	    return GlobalVector(0.,0.,3.8 - 1e-3 * std::abs(point.z()) - 2e-3 * point.perp());
+	}
+    };
+
+    // the edges, the values right below and right above the edges, and values outside the range
+    std::vector<double> probes(const std::vector<double> & edges)
+    {
+	std::vector<double> result;
+	for(double edge : edges)
+	{
+	    result.push_back(edge);
+	    result.push_back(std::nextafter(edge,-std::numeric_limits<double>::infinity()));
+	    result.push_back(std::nextafter(edge,std::numeric_limits<double>::infinity()));
+	}
+	result.push_back(edges.front() - 1.);
+	result.push_back(edges.back() + 1.);
+	result.push_back(edges.back() * 10.);
+	return result;
+    }
+
+    std::vector<double> uniformEdges(unsigned nBins,double low,double high)
+    {
+	std::vector<double> edges;
+	for(unsigned i = 0;i <= nBins;i++)
+	{
+	    edges.push_back(low + i * (high - low) / nBins);
+	}
+	return edges;
+    }
+
+    // bin i of the histogram gets the value i, the underflow -1
+    void fill(TH1F & hist,unsigned nBins)
+    {
+	hist.SetDirectory(0);
+	for(unsigned i = 0;i <= nBins + 1;i++)
+	{
+	    hist.SetBinContent(i,i == 0 ? -1. : double(i));
+	}
+    }
+
+    std::vector<double> binNumbers(unsigned nBins)
+    {
+	std::vector<double> values;
+	for(unsigned i = 1;i <= nBins;i++)
+	{
+	    values.push_back(i);
+	}
+	return values;
+    }
+
+    void expectSameBins(const fastsim::LookupTable & table,TH1F & hist,const std::vector<double> & xs)
+    {
+	for(double x : xs)
+	{
+	    EXPECT_EQ(hist.GetBinContent(hist.GetXaxis()->FindBin(x)),table.value(x)) << "x = " << x;
+	}
+    }
+
+    // ranges of the field tables in fastsim::Geometry (maxRadius, maxZ) and the test geometry
+    const std::vector<double> fieldRanges = {240.,600.,120.,300.};
+}
+
+TEST(LookupTable, UniformBinsAsTH1F)
+{
+    const unsigned nBins = 100;
+    for(double range : fieldRanges)
+    {
+	TH1F hist("h","h",nBins,0.,range);
+	fill(hist,nBins);
+	fastsim::LookupTable table(nBins,0.,range,binNumbers(nBins),-1.,nBins + 1);
+	EXPECT_TRUE(table.isUniform());
+	expectSameBins(table,hist,probes(uniformEdges(nBins,0.,range)));
+    }
+    // range not starting at 0
+    TH1F hist("h","h",7,-2.5,3.1);
+    fill(hist,7);
+    fastsim::LookupTable table(7,-2.5,3.1,binNumbers(7),-1.,8.);
+    expectSameBins(table,hist,probes(uniformEdges(7,-2.5,3.1)));
+}
+
+TEST(LookupTable, VariableBinsAsTH1F)
+{
+    std::vector<std::vector<double> > edgesList = {
+	{0.0,28.391}, // BPix
+	{0.0,18.0,30.0,36.0,46.0,55.0,108.737}, // TOB
+	{29.62,32.0,40.0,41.0,46.0,111.395}, // TEC
+	{0.0,10.0,20.0,30.0}, // equidistant
+	{4.2,5.1,7.1,7.1,8.2,10.0,10.0,10.0,11.9} // bins of zero width
+    };
+    for(const std::vector<double> & edges : edgesList)
+    {
+	unsigned nBins = edges.size() - 1;
+	TH1F hist("h","h",nBins,&edges[0]);
+	fill(hist,nBins);
+	fastsim::LookupTable table(edges,binNumbers(nBins),-1.,nBins + 1);
+	EXPECT_FALSE(table.isUniform());
+	expectSameBins(table,hist,probes(edges));
+    }
+}
+
+TEST(LookupTable, NaNIsOverflowAsTH1F)
+{
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> edges = {0.,1.,3.};
+    TH1F hist("h","h",2,&edges[0]);
+    fill(hist,2);
+    expectSameBins(fastsim::LookupTable(edges,binNumbers(2),-1.,3.),hist,{nan});
+    TH1F uniformHist("h","h",2,0.,3.);
+    fill(uniformHist,2);
+    expectSameBins(fastsim::LookupTable(2,0.,3.,binNumbers(2),-1.,3.),uniformHist,{nan});
+}
+
+TEST(LookupTable, BadBinning)
+{
+    EXPECT_THROW(fastsim::LookupTable({0.,1.,2.},{1.}),cms::Exception);
+    EXPECT_THROW(fastsim::LookupTable({0.},{}),cms::Exception);
+    EXPECT_THROW(fastsim::LookupTable({0.,2.,1.},{1.,2.}),cms::Exception);
+    EXPECT_THROW(fastsim::LookupTable(2,0.,1.,{1.}),cms::Exception);
+    EXPECT_THROW(fastsim::LookupTable(0,0.,1.,{}),cms::Exception);
+    EXPECT_THROW(fastsim::LookupTable(1,1.,1.,{1.}),cms::Exception);
+}
+
+// the field and thickness of the layers built by LayerFactory, compared to the histograms it used to fill
+TEST(LookupTable, LayerFieldAndThicknessAsTH1F)
+{
+    TestMagneticField magneticField;
+    const double maxRadius = 240., maxZ = 600.;
+    fastsim::LayerFactory layerFactory(0,magneticField,maxRadius,maxZ);
+
+    std::vector<double> limits = {0.0,18.0,30.0,36.0,46.0,55.0,108.737};
+    std::vector<double> thickness = {0.021,0.06,0.03,0.06,0.03,0.06};
+    edm::ParameterSet cfg;
+    cfg.addUntrackedParameter<std::vector<double> >("limits",limits);
+    cfg.addUntrackedParameter<std::vector<double> >("thickness",thickness);
+    cfg.addUntrackedParameter<std::vector<std::string> >("interactionModels",std::vector<std::string>());
+    const double radius = 60.937, z = 127.5;
+    edm::ParameterSet barrelCfg(cfg);
+    barrelCfg.addUntrackedParameter<double>("radius",radius);
+    edm::ParameterSet forwardCfg(cfg);
+    forwardCfg.addUntrackedParameter<double>("z",z);
+    std::unique_ptr<fastsim::BarrelLayer> barrelLayer = layerFactory.createBarrelLayer(barrelCfg);
+    std::unique_ptr<fastsim::ForwardLayer> forwardLayer = layerFactory.createForwardLayer(fastsim::LayerFactory::POSFWD,forwardCfg);
+
+    // histograms as filled by LayerFactory before, bin 101 (overflow) included
+    TH1F thicknessHist("h","h",limits.size() - 1,&limits[0]);
+    thicknessHist.SetDirectory(0);
+    for(unsigned i = 1;i < limits.size();i++)
+    {
+	thicknessHist.SetBinContent(i,thickness[i-1]);
+    }
+    TH1F barrelFieldHist("h","h",100,0.,maxZ);
+    TH1F forwardFieldHist("h","h",100,0.,maxRadius);
+    barrelFieldHist.SetDirectory(0);
+    forwardFieldHist.SetDirectory(0);
+    for(unsigned i = 1;i <= 101;i++)
+    {
+	barrelFieldHist.SetBinContent(i,magneticField.inTesla(GlobalPoint(radius,0.,barrelFieldHist.GetXaxis()->GetBinCenter(i))).z());
+	forwardFieldHist.SetBinContent(i,magneticField.inTesla(GlobalPoint(forwardFieldHist.GetXaxis()->GetBinCenter(i),0.,z)).z());
+    }
+
+    // momentum perpendicular to the layer: the thickness is not scaled
+    for(double position : probes(uniformEdges(100,0.,maxZ)))
+    {
+	position = std::abs(position);
+	math::XYZTLorentzVector onLayer(radius,0.,position,0.);
+	EXPECT_FLOAT_EQ(barrelFieldHist.GetBinContent(barrelFieldHist.GetXaxis()->FindBin(position)),barrelLayer->getMagneticFieldZ(onLayer)) << "z = " << position;
+    }
+    for(double position : probes(limits))
+    {
+	position = std::abs(position);
+	math::XYZTLorentzVector onLayer(radius,0.,position,0.);
+	EXPECT_FLOAT_EQ(thicknessHist.GetBinContent(thicknessHist.GetXaxis()->FindBin(position)),barrelLayer->getThickness(onLayer,math::XYZTLorentzVector(1.,0.,0.,1.))) << "z = " << position;
+    }
+    for(double position : probes(uniformEdges(100,0.,maxRadius)))
+    {
+	position = std::abs(position);
+	math::XYZTLorentzVector onLayer(position,0.,z,0.);
+	EXPECT_FLOAT_EQ(forwardFieldHist.GetBinContent(forwardFieldHist.GetXaxis()->FindBin(position)),forwardLayer->getMagneticFieldZ(onLayer)) << "r = " << position;
+    }
+    for(double position : probes(limits))
+    {
+	position = std::abs(position);
+	math::XYZTLorentzVector onLayer(position,0.,z,0.);
+	EXPECT_FLOAT_EQ(thicknessHist.GetBinContent(thicknessHist.GetXaxis()->FindBin(position)),forwardLayer->getThickness(onLayer,math::XYZTLorentzVector(0.,0.,1.,1.))) << "r = " << position;
+    }
+
+    // beyond the range: the field at the center of the 101st bin, as in the overflow of the histograms
+    EXPECT_FLOAT_EQ(magneticField.inTesla(GlobalPoint(radius,0.,maxZ * 1.005)).z(),barrelLayer->getMagneticFieldZ(math::XYZTLorentzVector(radius,0.,maxZ + 50.,0.)));
+    EXPECT_FLOAT_EQ(magneticField.inTesla(GlobalPoint(maxRadius * 1.005,0.,z)).z(),forwardLayer->getMagneticFieldZ(math::XYZTLorentzVector(maxRadius + 50.,0.,z,0.)));
+}
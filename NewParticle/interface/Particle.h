@@ -3,6 +3,8 @@
 
 #include "DataFormats/Math/interface/LorentzVector.h"
 
+#include <cstddef>
+
 namespace fastsim
 {
     class Particle
@@ -12,7 +14,7 @@ namespace fastsim
 		 const math::XYZTLorentzVector & position,
 		 const math::XYZTLorentzVector & momentum)
 	    : pdgId_(pdgId)
-	    , charge_(-999.)
+	    , charge_(unsetCharge)
 	    , position_(position)
 	    , momentum_(momentum)
 	    , remainingProperLifeTime_(-999.)
@@ -42,7 +44,7 @@ namespace fastsim
 	bool isStable() const {return remainingProperLifeTime_ == -1.;}
 
 	// other
-    bool chargeIsSet() const {return charge_!=-999.;}
+    bool chargeIsSet() const {return charge_!=unsetCharge;}
 	bool remainingProperLifeTimeIsSet() const {return remainingProperLifeTime_ != -999.;}
 	double gamma() const { return momentum().M() / momentum().E(); };
 
@@ -52,6 +54,14 @@ namespace fastsim
 
 	friend std::ostream& operator << (std::ostream& os , const Particle & particle);
 
+	// value of the charge until it is set
+	static constexpr double unsetCharge = -999.;
+
+	// particles are created and destroyed at a high rate (gen particles, brem photons, decay products...)
+	// their memory is taken from the current fastsim::ParticleArena (see ParticleArena.h) rather than from the global allocator
+	static void * operator new(std::size_t size);
+	static void operator delete(void * p,std::size_t size);
+
     private:
 	const int pdgId_;
 	double charge_;
@@ -0,0 +1,71 @@
+#ifndef FASTSIM_PARTICLEARENA_H
+#define FASTSIM_PARTICLEARENA_H
+
+#include <cstddef>
+#include <vector>
+
+namespace fastsim
+{
+    // memory of the particles of an event
+    //    - owned by whoever simulates the event (FastSimProducer: one per stream)
+    //      and made current on the running thread with a ParticleArena::Scope
+    //    - particles created while an arena is current take their memory from it,
+    //      particles created outside of any scope use the global allocator
+    //    - the memory of destroyed particles is recycled within the event,
+    //      reset (at the end of the event) makes all of it available again
+    //    - chunks are kept across events and released by the destructor
+    // each particle remembers the arena it comes from, such that it is returned to that arena when destroyed.
+    // the arena is not thread safe:
+    // its particles must be destroyed by the task that created them, before the arena is reset or destroyed.
+    class ParticleArena
+    {
+    public:
+	ParticleArena();
+	~ParticleArena();
+	ParticleArena(const ParticleArena &) = delete;
+	ParticleArena & operator = (const ParticleArena &) = delete;
+
+	// makes an arena the current one of this thread, for the lifetime of the scope
+	class Scope
+	{
+	public:
+	    Scope(ParticleArena & arena);
+	    ~Scope();
+	    Scope(const Scope &) = delete;
+	    Scope & operator = (const Scope &) = delete;
+	private:
+	    ParticleArena * previous_;
+	};
+
+	// arena of the innermost scope on this thread, 0 if none
+	static ParticleArena * current();
+
+	// memory for a fastsim::Particle: from the current arena, or from the global allocator if there is none
+	static void * allocateParticle();
+	static void deallocateParticle(void * p);
+
+	// all memory becomes available again, the chunks are kept
+	// throws if particles of this arena are still alive
+	void reset();
+
+	unsigned nLiveParticles() const {return nLiveParticles_;}
+	std::size_t nChunks() const {return chunks_.size();}
+
+    private:
+	union Block;
+
+	Block * allocate();
+	void deallocate(Block * block);
+
+	static const unsigned chunkSize_;
+	std::vector<Block *> chunks_;
+	// blocks that were used and given back
+	Block * freeList_;
+	// blocks that were never used since the last reset: from block nextBlock_ of chunk nextChunk_ on
+	std::size_t nextChunk_;
+	unsigned nextBlock_;
+	unsigned nLiveParticles_;
+    };
+}
+
+#endif
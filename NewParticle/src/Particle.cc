@@ -1,4 +1,29 @@
 #include "FastSimulation/NewParticle/interface/Particle.h"
+#include "FastSimulation/NewParticle/interface/ParticleArena.h"
+
+void * fastsim::Particle::operator new(std::size_t size)
+{
+    // classes deriving from Particle do not fit in the blocks of the arena
+    if(size != sizeof(Particle))
+    {
+	return ::operator new(size);
+    }
+    return ParticleArena::allocateParticle();
+}
+
+void fastsim::Particle::operator delete(void * p,std::size_t size)
+{
+    if(p == 0)
+    {
+	return;
+    }
+    if(size != sizeof(Particle))
+    {
+	::operator delete(p);
+	return;
+    }
+    ParticleArena::deallocateParticle(p);
+}
 
 std::ostream& fastsim::operator << (std::ostream& os , const fastsim::Particle & particle)
 {
@@ -0,0 +1,132 @@
+#include "FastSimulation/NewParticle/interface/ParticleArena.h"
+#include "FastSimulation/NewParticle/interface/Particle.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+namespace
+{
+    thread_local fastsim::ParticleArena * currentArena = 0;
+
+    // memory of one particle, preceded by the arena it belongs to (0: global allocator)
+    struct ParticleMemory
+    {
+	fastsim::ParticleArena * owner;
+	std::aligned_storage<sizeof(fastsim::Particle),alignof(fastsim::Particle)>::type storage;
+    };
+
+    ParticleMemory * particleMemory(void * p)
+    {
+	return reinterpret_cast<ParticleMemory *>(static_cast<char *>(p) - offsetof(ParticleMemory,storage));
+    }
+}
+
+union fastsim::ParticleArena::Block
+{
+    Block * next;
+    ParticleMemory memory;
+};
+
+const unsigned fastsim::ParticleArena::chunkSize_ = 1024;
+
+fastsim::ParticleArena::ParticleArena()
+    : freeList_(0)
+    , nextChunk_(0)
+    , nextBlock_(0)
+    , nLiveParticles_(0)
+{;}
+
+fastsim::ParticleArena::~ParticleArena()
+{
+    for(Block * chunk : chunks_)
+    {
+	::operator delete(chunk);
+    }
+}
+
+fastsim::ParticleArena::Scope::Scope(ParticleArena & arena)
+    : previous_(currentArena)
+{
+    currentArena = &arena;
+}
+
+fastsim::ParticleArena::Scope::~Scope()
+{
+    currentArena = previous_;
+}
+
+fastsim::ParticleArena * fastsim::ParticleArena::current()
+{
+    return currentArena;
+}
+
+void * fastsim::ParticleArena::allocateParticle()
+{
+    ParticleMemory * memory = 0;
+    if(currentArena)
+    {
+	memory = &currentArena->allocate()->memory;
+    }
+    else
+    {
+	memory = static_cast<ParticleMemory *>(::operator new(sizeof(ParticleMemory)));
+    }
+    memory->owner = currentArena;
+    return &memory->storage;
+}
+
+void fastsim::ParticleArena::deallocateParticle(void * p)
+{
+    ParticleMemory * memory = particleMemory(p);
+    if(memory->owner)
+    {
+	// (the memory is the first member of the block)
+	memory->owner->deallocate(reinterpret_cast<Block *>(memory));
+    }
+    else
+    {
+	::operator delete(memory);
+    }
+}
+
+fastsim::ParticleArena::Block * fastsim::ParticleArena::allocate()
+{
+    ++nLiveParticles_;
+    if(freeList_)
+    {
+	Block * block = freeList_;
+	freeList_ = block->next;
+	return block;
+    }
+    if(nextChunk_ < chunks_.size() && nextBlock_ == chunkSize_)
+    {
+	++nextChunk_;
+	nextBlock_ = 0;
+    }
+    if(nextChunk_ == chunks_.size())
+    {
+	chunks_.push_back(static_cast<Block *>(::operator new(chunkSize_ * sizeof(Block))));
+	nextBlock_ = 0;
+    }
+    return &chunks_[nextChunk_][nextBlock_++];
+}
+
+void fastsim::ParticleArena::deallocate(Block * block)
+{
+    --nLiveParticles_;
+    block->next = freeList_;
+    freeList_ = block;
+}
+
+void fastsim::ParticleArena::reset()
+{
+    if(nLiveParticles_ != 0)
+    {
+	throw cms::Exception("fastsim::ParticleArena") << "reset while " << nLiveParticles_ << " particle(s) of the arena are still alive";
+    }
+    freeList_ = 0;
+    nextChunk_ = 0;
+    nextBlock_ = 0;
+}
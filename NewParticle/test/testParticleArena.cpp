@@ -0,0 +1,92 @@
+#include "FastSimulation/NewParticle/interface/Particle.h"
+#include "FastSimulation/NewParticle/interface/ParticleArena.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace
+{
+    std::unique_ptr<fastsim::Particle> makeParticle()
+    {
+	return std::unique_ptr<fastsim::Particle>(new fastsim::Particle(22,math::XYZTLorentzVector(0.,0.,0.,0.),math::XYZTLorentzVector(1.,0.,0.,1.)));
+    }
+}
+
+TEST(ParticleArena, ParticlesOutsideOfAScopeUseTheGlobalAllocator)
+{
+    fastsim::ParticleArena arena;
+    std::unique_ptr<fastsim::Particle> particle = makeParticle();
+    EXPECT_EQ(0u,arena.nLiveParticles());
+    EXPECT_EQ(0u,arena.nChunks());
+    EXPECT_EQ(0,fastsim::ParticleArena::current());
+}
+
+TEST(ParticleArena, ScopesNest)
+{
+    fastsim::ParticleArena outer, inner;
+    {
+	fastsim::ParticleArena::Scope outerScope(outer);
+	{
+	    fastsim::ParticleArena::Scope innerScope(inner);
+	    EXPECT_EQ(&inner,fastsim::ParticleArena::current());
+	}
+	EXPECT_EQ(&outer,fastsim::ParticleArena::current());
+    }
+    EXPECT_EQ(0,fastsim::ParticleArena::current());
+}
+
+TEST(ParticleArena, ResetReusesTheChunks)
+{
+    fastsim::ParticleArena arena;
+    fastsim::ParticleArena::Scope scope(arena);
+    std::set<const fastsim::Particle *> firstEvent;
+    for(unsigned event = 0;event < 2;++event)
+    {
+	std::vector<std::unique_ptr<fastsim::Particle> > particles;
+	for(unsigned index = 0;index < 3000;++index)
+	{
+	    particles.push_back(makeParticle());
+	    if(event == 0)
+	    {
+		firstEvent.insert(particles.back().get());
+	    }
+	    else
+	    {
+		EXPECT_EQ(1u,firstEvent.count(particles.back().get()));
+	    }
+	}
+	EXPECT_EQ(3000u,arena.nLiveParticles());
+	particles.clear();
+	arena.reset();
+	EXPECT_EQ(3u,arena.nChunks());
+    }
+}
+
+TEST(ParticleArena, ResetThrowsIfParticlesAreAlive)
+{
+    fastsim::ParticleArena arena;
+    fastsim::ParticleArena::Scope scope(arena);
+    std::unique_ptr<fastsim::Particle> particle = makeParticle();
+    EXPECT_THROW(arena.reset(),cms::Exception);
+    particle.reset();
+    EXPECT_NO_THROW(arena.reset());
+}
+
+TEST(ParticleArena, ParticlesReturnToTheirOwnArena)
+{
+    fastsim::ParticleArena arena;
+    std::unique_ptr<fastsim::Particle> particle;
+    {
+	fastsim::ParticleArena::Scope scope(arena);
+	particle = makeParticle();
+    }
+    fastsim::ParticleArena other;
+    fastsim::ParticleArena::Scope scope(other);
+    particle.reset();
+    EXPECT_EQ(0u,arena.nLiveParticles());
+    EXPECT_EQ(0u,other.nLiveParticles());
+}
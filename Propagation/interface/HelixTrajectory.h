@@ -1,4 +1,3 @@
-
 #ifndef FASTSIM_HELIXTRAJECTORY_H
 #define FASTSIM_HELIXTRAJECTORY_H
 
@@ -11,17 +10,24 @@ namespace fastsim
     public:
 	HelixTrajectory(const Particle & particle,double magneticFieldZ);
 	bool crosses(const BarrelLayer & layer) const override;
+	bool staysOutside(double radius) const override;
 	double nextCrossingTimeC(const BarrelLayer & layer) const override;
 	void move(double deltaTimeC) override;
     private:
 	const double radius_;
-	const double phi_;
+	const double phiSpeed_;
+	// phase of the current position w.r.t. the center of the helix
+	double cosPhi_;
+	double sinPhi_;
 	const double centerX_;
 	const double centerY_;
 	const double centerR_;
+	// centerR_ - radius_, computed without cancellation for large radii
+	const double centerRMinusRadius_;
 	const double minR_;
 	const double maxR_;
-	const double phiSpeed_;
+	// phase difference between the direction from the center to the origin and the current position
+	double deltaPhiToOrigin_;
     };
 }
 
@@ -2,6 +2,10 @@
 #define FASTSIM_LAYERNAVIGATOR_H
 
 #include "string"
+#include "vector"
+
+#include "DataFormats/Math/interface/LorentzVector.h"
+#include "FastSimulation/Propagation/interface/TrajectoryVariant.h"
 
 namespace fastsim
 {
@@ -10,18 +14,79 @@ namespace fastsim
     class BarrelLayer;
     class Geometry;
     class Particle;
+    class Trajectory;
     class LayerNavigator
     {
     public:
+	// why moveParticleToNextLayer returned false
+	enum ExitState
+	{
+	    INSIDE=0,        // the particle is still being navigated
+	    ESCAPED,         // the particle left the tracker volume (Geometry::getMaxRadius, getMaxZ) and cannot come back
+	    NOCROSSING,      // the trajectory does not cross any further layer
+	    DECAYED,         // the particle reached the end of its life (it is at its decay point)
+	    OUTOFTIME,       // the particle was stopped by one of the time cuts
+	    LOOPERSTOPPED    // the particle was stopped by the looper budget (see setMaxLooperTurns)
+	};
 	LayerNavigator(const Geometry & geometry);
+	// navigator that only stops the particle on relevant layers,
+	// i.e. layers for which the corresponding entry (by layer index) in barrelLayerIsRelevant / forwardLayerIsRelevant is true
+	// crossings with other layers are computed, but the particle is moved on without returning to the caller
+	LayerNavigator(const Geometry & geometry,
+		       const std::vector<bool> & barrelLayerIsRelevant,
+		       const std::vector<bool> & forwardLayerIsRelevant);
 	// TODO: make the layer const
+	// a call with layer == 0 starts the navigation of a new particle, i.e. a navigator can be reused for many particles
 	bool moveParticleToNextLayer(Particle & particle,const Layer * & layer);
+	// stop loopers (charged particles curling between two barrel layers)
+	// that need more than maxLooperTurns turns to reach the next forward layer
+	// (maxLooperTurns <= 0: no limit, default)
+	void setMaxLooperTurns(double maxLooperTurns) {maxLooperTurns_ = maxLooperTurns;}
+	// exit state of the last particle, INSIDE as long as moveParticleToNextLayer returns true
+	ExitState exitState() const {return exitState_;}
     private:
+	bool moveParticleToNextCrossing(Particle & particle,const Layer * & layer);
+	bool moveStraightParticleToNextCrossing(Particle & particle,const Layer * & layer);
+	void planStraightLine(const Particle & particle);
+	bool isRelevant(const Layer & layer) const;
+	bool escapes(const Particle & particle,const Trajectory & trajectory) const;
 	const Geometry * const geometry_;
+	const std::vector<bool> * const barrelLayerIsRelevant_;
+	const std::vector<bool> * const forwardLayerIsRelevant_;
+	double maxLooperTurns_;
+	ExitState exitState_;
     const BarrelLayer * nextBarrelLayer_;
 	const BarrelLayer * previousBarrelLayer_;
     const ForwardLayer * nextForwardLayer_;
 	const ForwardLayer * previousForwardLayer_;
+	// trajectory of the last step, continued as long as neither the particle nor the magnetic field change
+	TrajectoryVariant trajectory_;
+	double trajectoryMagneticFieldZ_;
+	math::XYZTLorentzVector lastMomentum_;
+	// straight line navigation: all crossings of the particle with the layers, ordered in time
+	struct Crossing
+	{
+	    double timeC;
+	    const Layer * layer;
+	    // barrel layers: crossing while moving inwards
+	    bool inwards;
+	    bool operator<(const Crossing & other) const {return timeC < other.timeC;}
+	};
+	std::vector<Crossing> straightLinePlan_;
+	unsigned nextCrossing_;
+	double lastCrossingTimeC_;
+	// state of the particle at the start of the plan
+	math::XYZTLorentzVector planPosition_;
+	math::XYZTLorentzVector planMomentum_;
+	// the plan ends where the line leaves the tracker volume
+	bool planLeavesVolume_;
+	// position of the particle after the last step
+	math::XYZTLorentzVector lastPosition_;
+	// temporary time cuts, to get rid of additional hits since there is no ecal and stuff yet
+	// on the time of the particle [ns]
+	static const double maxTime_;
+	// on the duration of a single step, as t*c [cm] (see Trajectory::nextCrossingTimeC)
+	static const double maxStepTimeC_;
 	static const std::string MESSAGECATEGORY;
     };
 }
@@ -10,6 +10,7 @@ namespace fastsim
     public:
 	StraightTrajectory(const Particle & particle) : Trajectory(particle) {;}
 	bool crosses(const BarrelLayer & layer) const override {return true;}
+	bool staysOutside(double radius) const override;
 	double nextCrossingTimeC(const BarrelLayer & layer) const override;
 	void move(double deltaTimeC) override;
     };
@@ -1,8 +1,6 @@
 #ifndef FASTSIM_TRAJECTORY_H
 #define FASTSIM_TRAJECTORY_H
 
-#include "memory"
-
 #include "DataFormats/Math/interface/LorentzVector.h"
 
 namespace fastsim
@@ -11,11 +9,15 @@ namespace fastsim
     class BarrelLayer;
     class ForwardLayer;
     class Particle;
+    class TrajectoryVariant;
     class Trajectory
     {
     public:
-	static std::unique_ptr<Trajectory> createTrajectory(const fastsim::Particle & particle,const double magneticFieldZ);
+	// trajectories are created through TrajectoryVariant::set
+	virtual ~Trajectory(){;}
 	virtual bool crosses(const BarrelLayer & layer) const = 0;
+	// true if the trajectory never gets closer than radius to the z axis (from the current position on)
+	virtual bool staysOutside(double radius) const = 0;
 	const math::XYZTLorentzVector & getPosition(){return position_;}
 	const math::XYZTLorentzVector & getMomentum(){return momentum_;}
 	double nextCrossingTimeC(const Layer & layer) const;
@@ -28,6 +30,7 @@ namespace fastsim
 	math::XYZTLorentzVector momentum_;
 	static const double speedOfLight_; // in cm / ns
 	static const double epsiloneTimeC_;
+	friend class TrajectoryVariant;
     };
 }
 
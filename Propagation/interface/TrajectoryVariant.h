@@ -0,0 +1,40 @@
+#ifndef FASTSIM_TRAJECTORYVARIANT_H
+#define FASTSIM_TRAJECTORYVARIANT_H
+
+#include <type_traits>
+
+#include "FastSimulation/Propagation/interface/StraightTrajectory.h"
+#include "FastSimulation/Propagation/interface/HelixTrajectory.h"
+
+namespace fastsim
+{
+    class Particle;
+
+    // holds either a StraightTrajectory or a HelixTrajectory in place,
+    // such that creating a trajectory on every navigation step does not touch the heap
+    class TrajectoryVariant
+    {
+    public:
+	TrajectoryVariant() : trajectory_(0), isHelix_(false) {;}
+	~TrajectoryVariant() { reset(); }
+	TrajectoryVariant(const TrajectoryVariant &) = delete;
+	TrajectoryVariant & operator=(const TrajectoryVariant &) = delete;
+
+	// construct the type of trajectory that corresponds to the particle's charge and the magnetic field
+	// (replaces the trajectory held so far, if any)
+	Trajectory & set(const Particle & particle,double magneticFieldZ);
+	void reset();
+
+	bool isSet() const {return trajectory_ != 0;}
+	bool isHelix() const {return isHelix_;}
+	Trajectory & operator*() {return *trajectory_;}
+	Trajectory * operator->() {return trajectory_;}
+
+    private:
+	std::aligned_union<0,StraightTrajectory,HelixTrajectory>::type storage_;
+	Trajectory * trajectory_;
+	bool isHelix_;
+    };
+}
+
+#endif
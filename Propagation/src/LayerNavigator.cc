@@ -1,15 +1,14 @@
 #include "FastSimulation/Propagation/interface/LayerNavigator.h"
 
-#include "vector"
-
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
 
 #include "FastSimulation/Geometry/interface/Geometry.h"
 #include "FastSimulation/Layer/interface/BarrelLayer.h"
 #include "FastSimulation/Layer/interface/ForwardLayer.h"
 #include "FastSimulation/Propagation/interface/LayerNavigator.h"
-#include "FastSimulation/Propagation/interface/Trajectory.h"      // new class, to be defined, based on ParticlePropagator
+#include "FastSimulation/Propagation/interface/TrajectoryVariant.h"
 #include "FastSimulation/NewParticle/interface/Particle.h"
+#include "FastSimulation/Constants/interface/Constants.h"
 
 /**
 // find the next layer that the particle will cross
@@ -54,21 +53,100 @@
 //    - the implementation of the algorithm can probably be optimised, e.g.
 //       - one can probably gain time in moveToNextLayer if LayerNavigator is aware of the candidate layers of the previous call to moveToNextLayer
 //       - for straight tracks, the optimal strategy to find the next layer might be very different
+//
+// skipping layers
+//    - layers on which none of the interaction models can act on the particle need not be returned to the caller:
+//      if relevance masks are provided, the navigator moves on to the next crossing until it reaches a relevant layer
+//    - every skipped crossing is computed exactly as if the caller had asked for it,
+//      so the trajectory, the magnetic field used on each step and the decay point are the same with and without skipping
+//
+// straight lines
+//    - neutral particles move on a straight line, independent of the magnetic field:
+//      all their crossings with the layers are computed in one go when the navigation starts (see planStraightLine),
+//      and then replayed step by step
+//    - the plan is recomputed if the particle was changed (e.g. by an interaction) between two steps
+//    - the plan ends where the line leaves the tracker volume, the navigation then stops with exit state ESCAPED
+//
+// loopers
+//    - a helix that reaches neither of the two enclosing barrel layers stays between them forever (as long as the particle is not modified)
+//    - only the crossing with the next forward layer needs to be computed
+//    - soft loopers can take very many turns to get there: they can be stopped after a configurable number of turns (see setMaxLooperTurns)
+//
+// leaving the tracker
+//    - all layers are inside the tracker volume (|z| <= Geometry::getMaxZ(), r <= Geometry::getMaxRadius(), checked by Geometry::update)
+//    - a particle outside that volume that moves away from it (in z, or in r for its whole trajectory) cannot cross any further layer:
+//      the navigation stops before any crossing is computed
+//    - the reason why the navigation of a particle stopped is available from exitState()
 **/
 
+#include <algorithm>
+#include <cmath>
+
+const double fastsim::LayerNavigator::maxTime_ = 100;      // ns
+const double fastsim::LayerNavigator::maxStepTimeC_ = 100; // cm
 const std::string fastsim::LayerNavigator::MESSAGECATEGORY = "FastSimulation";
 
 fastsim::LayerNavigator::LayerNavigator(const fastsim::Geometry & geometry)
     : geometry_(&geometry)
+    , barrelLayerIsRelevant_(0)
+    , forwardLayerIsRelevant_(0)
+    , maxLooperTurns_(-1)
+    , exitState_(INSIDE)
     , nextBarrelLayer_(0)
     , previousBarrelLayer_(0)
     , nextForwardLayer_(0)
     , previousForwardLayer_(0)
+    , trajectoryMagneticFieldZ_(0)
+    , nextCrossing_(0)
+    , lastCrossingTimeC_(0)
+    , planLeavesVolume_(false)
 {;}
 
+fastsim::LayerNavigator::LayerNavigator(const fastsim::Geometry & geometry,
+					const std::vector<bool> & barrelLayerIsRelevant,
+					const std::vector<bool> & forwardLayerIsRelevant)
+    : geometry_(&geometry)
+    , barrelLayerIsRelevant_(&barrelLayerIsRelevant)
+    , forwardLayerIsRelevant_(&forwardLayerIsRelevant)
+    , maxLooperTurns_(-1)
+    , exitState_(INSIDE)
+    , nextBarrelLayer_(0)
+    , previousBarrelLayer_(0)
+    , nextForwardLayer_(0)
+    , previousForwardLayer_(0)
+    , trajectoryMagneticFieldZ_(0)
+    , nextCrossing_(0)
+    , lastCrossingTimeC_(0)
+    , planLeavesVolume_(false)
+{
+    if(barrelLayerIsRelevant.size() != geometry.barrelLayers().size() || forwardLayerIsRelevant.size() != geometry.forwardLayers().size())
+    {
+	throw cms::Exception("FastSimulation") << "LayerNavigator: layer relevance masks do not match the geometry";
+    }
+}
+
+bool fastsim::LayerNavigator::isRelevant(const fastsim::Layer & layer) const
+{
+    const std::vector<bool> * isRelevant = layer.isForward() ? forwardLayerIsRelevant_ : barrelLayerIsRelevant_;
+    return isRelevant == 0 || (*isRelevant)[layer.index()];
+}
+
+bool fastsim::LayerNavigator::escapes(const fastsim::Particle & particle,const fastsim::Trajectory & trajectory) const
+{
+    // a particle on a layer on the boundary of the volume is outside, within the on-surface tolerance:
+    // otherwise, after crossing the last layer, rounding errors decide whether it goes on to the layers beyond the boundary
+    // z is linear in time, for straight lines and helices alike
+    if(std::abs(particle.position().Z()) >= geometry_->getMaxZ() - fastsim::Layer::epsilonDistanceZ_ && particle.position().Z()*particle.momentum().Z() >= 0)
+    {
+		return true;
+    }
+    return trajectory.staysOutside(geometry_->getMaxRadius() - fastsim::Layer::epsilonDistanceR_);
+}
+
 bool fastsim::LayerNavigator::moveParticleToNextLayer(fastsim::Particle & particle,const fastsim::Layer * & layer)
 {
     LogDebug(MESSAGECATEGORY) << "   moveToNextLayer called";
+    exitState_ = INSIDE;
 
     // if the layer is provided, the particle must be on it
     if(layer)
@@ -79,12 +157,54 @@ bool fastsim::LayerNavigator::moveParticleToNextLayer(fastsim::Particle & partic
 		    << "\n   Layer: " << *layer
 		    << "\n   Particle: " << particle;
 		}
+		if(particle.position().T() > maxTime_)
+		{
+		    LogDebug(MESSAGECATEGORY) << "   particle out of time";
+		    exitState_ = OUTOFTIME;
+		    layer = 0;
+		    return false;
+		}
+    }
+
+    while(moveParticleToNextCrossing(particle,layer))
+    {
+		if(isRelevant(*layer))
+		{
+		    return true;
+		}
+		// no interactions after the time cut: don't skip beyond it
+		if(particle.position().T() > maxTime_)
+		{
+		    LogDebug(MESSAGECATEGORY) << "   particle out of time";
+		    exitState_ = OUTOFTIME;
+		    layer = 0;
+		    return false;
+		}
+		LogDebug(MESSAGECATEGORY) << "   skipping layer: " << *layer;
+    }
+    return false;
+}
+
+bool fastsim::LayerNavigator::moveParticleToNextCrossing(fastsim::Particle & particle,const fastsim::Layer * & layer)
+{
+    if(particle.charge() == 0)
+    {
+		return moveStraightParticleToNextCrossing(particle,layer);
     }
 
     // magnetic field at the current position of the particle
     double magneticFieldZ = layer ? layer->getMagneticFieldZ(particle.position()) : geometry_->getMagneticFieldZ(particle.position());
     LogDebug(MESSAGECATEGORY) << "   magnetic field z component:" << magneticFieldZ;
 
+    // can the trajectory of the previous step be continued?
+    // yes, if this is not a new particle, the particle was not modified since the last step (e.g. by an interaction)
+    // and the magnetic field is exactly the same (e.g. fixed magnetic field, or flat field map in the central tracker)
+    bool continueTrajectory = layer
+	&& trajectory_.isSet()
+	&& magneticFieldZ == trajectoryMagneticFieldZ_
+	&& particle.position() == lastPosition_
+	&& particle.momentum() == lastMomentum_;
+
     // particle moves inwards?
     bool particleMovesInwards = particle.momentum().X()*particle.position().X() + particle.momentum().Y()*particle.position().Y() < 0;
     
@@ -96,54 +216,68 @@ bool fastsim::LayerNavigator::moveParticleToNextLayer(fastsim::Particle & partic
     if(!layer)
     {		
 		LogDebug(MESSAGECATEGORY) << "      called for first time";
+		nextBarrelLayer_ = 0;
+		nextForwardLayer_ = 0;
 
 		//
 		// find the narrowest barrel layers with
 		// layer.r > particle.r (the closest layer with layer.r < particle.r will then be considered, too)
 		// assume barrel layers are ordered with increasing r
+		// all layers with layer.r < particle.r - 2*epsilon are neither on the particle's position nor outside it:
+		// binary search for the first layer that is not, the scan from there takes one or two steps
 		//
-		for(const auto & layer : geometry_->barrelLayers())
+		unsigned firstBarrelLayer = geometry_->lowerBoundBarrelLayer(particle.position().Pt() - 2.*fastsim::Layer::epsilonDistanceR_);
+		previousBarrelLayer_ = firstBarrelLayer > 0 ? geometry_->barrelLayers()[firstBarrelLayer - 1].get() : 0;
+		for(unsigned index = firstBarrelLayer;index < geometry_->barrelLayers().size();++index)
 		{
+			const BarrelLayer * layer = geometry_->barrelLayers()[index].get();
 			if(layer->isOnSurface(particle.position())){
 				if(particleMovesInwards){
-					nextBarrelLayer_ = layer.get();
+					nextBarrelLayer_ = layer;
 					break;
 				}else{
+					// passed, as in the update below: a helix can cross it again on its way back
+					previousBarrelLayer_ = layer;
 					continue;
 				}
 			}
 
 		    if(particle.position().Pt() < layer->getRadius())
 		    {
-				nextBarrelLayer_ = layer.get();
+				nextBarrelLayer_ = layer;
 				break;
 		    }
 
-			previousBarrelLayer_ = layer.get();
+			previousBarrelLayer_ = layer;
 		}
 
 		// 
 		//  find the forward layer with smallest z with
 		//  layer.z > particle z (the closest layer with layer.z < particle.z will then be considered, too)
+		//  (binary search as for the barrel layers)
 		//
-		for(const auto & layer : geometry_->forwardLayers())
+		unsigned firstForwardLayer = geometry_->lowerBoundForwardLayer(particle.position().Z() - 2.*fastsim::Layer::epsilonDistanceZ_);
+		previousForwardLayer_ = firstForwardLayer > 0 ? geometry_->forwardLayers()[firstForwardLayer - 1].get() : 0;
+		for(unsigned index = firstForwardLayer;index < geometry_->forwardLayers().size();++index)
 		{
+			const ForwardLayer * layer = geometry_->forwardLayers()[index].get();
 			if(layer->isOnSurface(particle.position())){
 				if(particle.momentum().Z() < 0){
-					nextForwardLayer_ = layer.get();
+					nextForwardLayer_ = layer;
 					break;
 				}else{
+					previousForwardLayer_ = layer;
 					continue;
 				}
 			}
 
 		    if(particle.position().Z() < layer->getZ())
 		    {
-				nextForwardLayer_ = layer.get();
+				nextForwardLayer_ = layer;
 				break;
 		    }
 
-			previousForwardLayer_ = layer.get();
+			previousForwardLayer_ = layer;
 		}
     }
     //
@@ -152,8 +286,11 @@ bool fastsim::LayerNavigator::moveParticleToNextLayer(fastsim::Particle & partic
     else
     {
 		LogDebug(MESSAGECATEGORY) << "      ordinary call";
+		// the particle is on the layer that was hit,
+		// and maybe on a layer of the other kind as well (the two crossings within the on-surface tolerance):
+		// both are passed, otherwise the crossing of the second one is lost (it is not ahead of the particle any more)
 		// barrel layer was hit
-		if(layer == nextBarrelLayer_)
+		if(nextBarrelLayer_ && (layer == nextBarrelLayer_ || (layer->isForward() && nextBarrelLayer_->isOnSurface(particle.position()))))
 		{
 		    if(!particleMovesInwards)
 		    {
@@ -161,7 +298,7 @@ bool fastsim::LayerNavigator::moveParticleToNextLayer(fastsim::Particle & partic
 				nextBarrelLayer_ = geometry_->nextLayer(nextBarrelLayer_);
 		    }
 		}
-		else if(layer == previousBarrelLayer_)
+		else if(previousBarrelLayer_ && (layer == previousBarrelLayer_ || (layer->isForward() && previousBarrelLayer_->isOnSurface(particle.position()))))
 		{
 		    if(particleMovesInwards)
 		    {
@@ -170,7 +307,7 @@ bool fastsim::LayerNavigator::moveParticleToNextLayer(fastsim::Particle & partic
 		    }
 		}
 		// forward layer was hit
-		else if(layer == nextForwardLayer_)
+		if(nextForwardLayer_ && (layer == nextForwardLayer_ || (!layer->isForward() && nextForwardLayer_->isOnSurface(particle.position()))))
 		{
 		    if(particle.momentum().Z() > 0)
 		    {
@@ -178,7 +315,7 @@ bool fastsim::LayerNavigator::moveParticleToNextLayer(fastsim::Particle & partic
 				nextForwardLayer_ = geometry_->nextLayer(nextForwardLayer_);
 		    }
 		}
-		else if(layer == previousForwardLayer_)
+		else if(previousForwardLayer_ && (layer == previousForwardLayer_ || (!layer->isForward() && previousForwardLayer_->isOnSurface(particle.position()))))
 		{
 		    if(particle.momentum().Z() < 0)
 		    {
@@ -200,37 +337,69 @@ bool fastsim::LayerNavigator::moveParticleToNextLayer(fastsim::Particle & partic
 			      << "\n   particle between ForwardLayers: " << (previousForwardLayer_ ? previousForwardLayer_->index() : -1) << "/" << (nextForwardLayer_ ? nextForwardLayer_->index() : -1) << " (total: "<< geometry_->forwardLayers().size() <<")";
     
     // calculate and store some variables related to the particle's trajectory
-    std::unique_ptr<fastsim::Trajectory> trajectory = Trajectory::createTrajectory(particle,magneticFieldZ);
+    // (the trajectory is held in place: navigation steps do not allocate)
+    // otherwise, the helix parameters (radius, center, phase speed) are kept from the previous step
+    if(!continueTrajectory)
+    {
+		trajectory_.set(particle,magneticFieldZ);
+		trajectoryMagneticFieldZ_ = magneticFieldZ;
+    }
+    Trajectory & trajectory = *trajectory_;
+
+    // no layer left to cross
+    if(escapes(particle,trajectory))
+    {
+		LogDebug(MESSAGECATEGORY) << "   particle escapes the tracker volume";
+		exitState_ = ESCAPED;
+		layer = 0;
+		return false;
+    }
     
+    // loopers: the helix reaches neither of the enclosing barrel layers
+    // only the next forward layer is left, its crossing is computed in closed form however many turns it takes
+    // (there is no per-turn stepping to fast-forward), loopers only differ by the looper budget below
+    bool isLooper = trajectory_.isHelix()
+	&& (nextBarrelLayer_ == 0 || !trajectory.crosses(*nextBarrelLayer_))
+	&& (previousBarrelLayer_ == 0 || !trajectory.crosses(*previousBarrelLayer_));
+
     // now let's try to move the particle to one of the enclosing layers
-    std::vector<const fastsim::Layer*> layers;
-    if(nextBarrelLayer_) 
+    const fastsim::Layer * layers[3];
+    unsigned nLayers = 0;
+    if(!isLooper)
     {
-		layers.push_back(nextBarrelLayer_);
+		if(nextBarrelLayer_) 
+		{
+		    layers[nLayers++] = nextBarrelLayer_;
+		}
+		if(previousBarrelLayer_)
+		{
+		    layers[nLayers++] = previousBarrelLayer_;
+		}
     }
-    if(previousBarrelLayer_)
+    else
     {
-		layers.push_back(previousBarrelLayer_);
+		LogDebug(MESSAGECATEGORY) << "   particle is a looper";
     }
     if(particle.momentum().Z() > 0)
     {
 		if(nextForwardLayer_)
 		{
-		    layers.push_back(nextForwardLayer_);
+		    layers[nLayers++] = nextForwardLayer_;
 		}
     }
     else
     {
 		if(previousForwardLayer_)
 		{
-		    layers.push_back(previousForwardLayer_);
+		    layers[nLayers++] = previousForwardLayer_;
 		}
     }
     
     double deltaTime = -1;
-    for(auto _layer : layers)
+    for(unsigned i = 0; i < nLayers; ++i)
     {
-		double tempDeltaTime = trajectory->nextCrossingTimeC(*_layer);
+		const fastsim::Layer * _layer = layers[i];
+		double tempDeltaTime = trajectory.nextCrossingTimeC(*_layer);
 		LogDebug(MESSAGECATEGORY) << "   particle crosses layer " << *_layer << " at time " << tempDeltaTime;
 		if(tempDeltaTime > 0 && (layer == 0 || tempDeltaTime<deltaTime || deltaTime < 0))
 		{
@@ -240,23 +409,61 @@ bool fastsim::LayerNavigator::moveParticleToNextLayer(fastsim::Particle & partic
     }
 
     // TODO : review time unit: ct or just t?
+    // the remaining life time is only updated once the particle is moved to its decay point:
+    // a particle stopped by the cuts below is left untouched
     double properDeltaTime = deltaTime / particle.gamma();
+    bool decays = false;
     if(!particle.isStable() && properDeltaTime > particle.remainingProperLifeTime())
     {
 		deltaTime = particle.remainingProperLifeTime() * particle.gamma();
-		particle.setRemainingProperLifeTime(0.);
+		decays = true;
     }
 
-    // temporary, to get rid of additional hits since there is no ecal and stuff yet
-    if(deltaTime > 100) return 0;
+    if(!layer)
+    {
+		exitState_ = NOCROSSING;
+    }
+    else if(deltaTime > maxStepTimeC_)
+    {
+		exitState_ = OUTOFTIME;
+		layer = 0;
+		return false;
+    }
+
+    // looper budget, on the time to the crossing or to the decay, whichever comes first
+    // one turn takes t*c = 2*pi*r * E/p_T = 2*pi * E / (c * 10^-4 * |q * B|)    (see HelixTrajectory)
+    if(isLooper && maxLooperTurns_ > 0)
+    {
+		double timeCPerTurn = 2. * M_PI * particle.momentum().E() / std::abs(fastsim::Constants::speedOfLight * 1e-4 * particle.charge() * magneticFieldZ);
+		if(deltaTime > maxLooperTurns_ * timeCPerTurn)
+		{
+		    LogDebug(MESSAGECATEGORY) << "   looper stopped after " << maxLooperTurns_ << " turns";
+		    exitState_ = LOOPERSTOPPED;
+		    layer = 0;
+		    return false;
+		}
+    }
 
     // move particle in space, time and momentum
     if(layer)
     {
-		trajectory->move(deltaTime);
-		particle.position() = trajectory->getPosition();
-		particle.momentum() = trajectory->getMomentum();
-		LogDebug(MESSAGECATEGORY) << "    moved particle to layer: " << *layer;
+		trajectory.move(deltaTime);
+		particle.position() = trajectory.getPosition();
+		particle.momentum() = trajectory.getMomentum();
+		lastPosition_ = particle.position();
+		lastMomentum_ = particle.momentum();
+		// the particle decays before it reaches the layer: it is not on any layer
+		if(decays)
+		{
+		    LogDebug(MESSAGECATEGORY) << "    moved particle to its decay point";
+		    particle.setRemainingProperLifeTime(0.);
+		    exitState_ = DECAYED;
+		    layer = 0;
+		}
+		else
+		{
+		    LogDebug(MESSAGECATEGORY) << "    moved particle to layer: " << *layer;
+		}
     }
 
     // return true / false if propagations succeeded /failed
@@ -265,3 +472,174 @@ bool fastsim::LayerNavigator::moveParticleToNextLayer(fastsim::Particle & partic
 }
 
 	
+
+void fastsim::LayerNavigator::planStraightLine(const fastsim::Particle & particle)
+{
+    straightLinePlan_.clear();
+    nextCrossing_ = 0;
+    lastCrossingTimeC_ = 0;
+    planPosition_ = particle.position();
+    planMomentum_ = particle.momentum();
+    const math::XYZTLorentzVector & position = planPosition_;
+    const math::XYZTLorentzVector & momentum = planMomentum_;
+
+    // barrel layers: same equation as in StraightTrajectory::nextCrossingTimeC,
+    // but all positive solutions are kept:
+    // a line that enters a layer leaves it again on the other side
+    double a = momentum.Perp2();
+    double b = position.X()*momentum.X() + position.Y()*momentum.Y();
+    if(a > 0)
+    {
+	for(const auto & barrelLayer : geometry_->barrelLayers())
+	{
+	    double c = position.Perp2() - barrelLayer->getRadius()*barrelLayer->getRadius();
+	    double delta = b*b - a*c;
+	    if(delta < 0)
+	    {
+		continue;
+	    }
+	    double sqrtDelta = sqrt(delta);
+	    double timesC[2] = {(-b - sqrtDelta)/a*momentum.E(), (-b + sqrtDelta)/a*momentum.E()};
+	    // the particle is on the layer: the solution closest to the current position is the current position
+	    if(barrelLayer->isOnSurface(position))
+	    {
+		timesC[std::abs(timesC[0]) < std::abs(timesC[1]) ? 0 : 1] = -1;
+	    }
+	    for(unsigned index = 0;index < 2;++index)
+	    {
+		if(timesC[index] > 0)
+		{
+		    straightLinePlan_.push_back(Crossing{timesC[index],barrelLayer.get(),index == 0});
+		}
+	    }
+	}
+    }
+
+    // forward layers: see Trajectory::nextCrossingTimeC
+    if(momentum.Z() != 0)
+    {
+	for(const auto & forwardLayer : geometry_->forwardLayers())
+	{
+	    if(forwardLayer->isOnSurface(position))
+	    {
+		continue;
+	    }
+	    double timeC = (forwardLayer->getZ() - position.Z()) / momentum.Z() * momentum.E();
+	    if(timeC > 0)
+	    {
+		straightLinePlan_.push_back(Crossing{timeC,forwardLayer.get(),false});
+	    }
+	}
+    }
+
+    // crossings after the line has left the tracker volume are dropped:
+    // the forward layers are infinite planes, the barrel layers infinite cylinders,
+    // but no crossing beyond maxRadius or maxZ is made by the step-wise navigation either (see escapes)
+    // (layers on the boundary of the volume are crossed at the exit time itself, computed in the same way: they are kept)
+    double exitTimeC = -1;
+    if(a > 0)
+    {
+	double c = position.Perp2() - geometry_->getMaxRadius()*geometry_->getMaxRadius();
+	double delta = b*b - a*c;
+	if(delta >= 0)
+	{
+	    exitTimeC = (-b + sqrt(delta))/a*momentum.E();
+	}
+    }
+    if(momentum.Z() != 0)
+    {
+	double timeC = ((momentum.Z() > 0 ? geometry_->getMaxZ() : -geometry_->getMaxZ()) - position.Z()) / momentum.Z() * momentum.E();
+	if(exitTimeC < 0 || timeC < exitTimeC)
+	{
+	    exitTimeC = timeC;
+	}
+    }
+    planLeavesVolume_ = exitTimeC >= 0;
+    if(planLeavesVolume_)
+    {
+	straightLinePlan_.erase(std::remove_if(straightLinePlan_.begin(),straightLinePlan_.end(),
+			       [exitTimeC](const Crossing & crossing){return crossing.timeC > exitTimeC;}),
+		    straightLinePlan_.end());
+    }
+
+    std::sort(straightLinePlan_.begin(),straightLinePlan_.end());
+    LogDebug(MESSAGECATEGORY) << "   straight line crosses " << straightLinePlan_.size() << " layers";
+}
+
+bool fastsim::LayerNavigator::moveStraightParticleToNextCrossing(fastsim::Particle & particle,const fastsim::Layer * & layer)
+{
+    // new particle, or particle modified since the last step
+    if(!layer || particle.momentum() != planMomentum_ || particle.position() != lastPosition_)
+    {
+	if(escapes(particle,StraightTrajectory(particle)))
+	{
+	    LogDebug(MESSAGECATEGORY) << "   particle escapes the tracker volume";
+	    exitState_ = ESCAPED;
+	    straightLinePlan_.clear();
+	    nextCrossing_ = 0;
+	    layer = 0;
+	    return false;
+	}
+	planStraightLine(particle);
+    }
+    layer = 0;
+
+    while(nextCrossing_ < straightLinePlan_.size())
+    {
+	const Crossing & crossing = straightLinePlan_[nextCrossing_++];
+	// crossings (nearly) coinciding with the current position of the particle are ignored, as in the step-wise navigation:
+	// forward layers the particle is on, and barrel layers the particle is on, if crossed in the current radial direction
+	if(crossing.layer->isOnSurface(particle.position()))
+	{
+	    bool particleMovesInwards = particle.momentum().X()*particle.position().X() + particle.momentum().Y()*particle.position().Y() < 0;
+	    if(crossing.layer->isForward() || crossing.inwards == particleMovesInwards)
+	    {
+		continue;
+	    }
+	}
+	double deltaTime = crossing.timeC - lastCrossingTimeC_;
+	double timeC = crossing.timeC;
+	LogDebug(MESSAGECATEGORY) << "   particle crosses layer " << *crossing.layer << " at time " << deltaTime;
+
+	// decays and time cut exactly as for other particles, see moveParticleToNextCrossing
+	double properDeltaTime = deltaTime / particle.gamma();
+	bool decays = false;
+	if(!particle.isStable() && properDeltaTime > particle.remainingProperLifeTime())
+	{
+	    deltaTime = particle.remainingProperLifeTime() * particle.gamma();
+	    timeC = lastCrossingTimeC_ + deltaTime;
+	    decays = true;
+	}
+
+	if(deltaTime > maxStepTimeC_)
+	{
+	    exitState_ = OUTOFTIME;
+	    return false;
+	}
+
+	// move the particle, from the start of the plan rather than step by step
+	particle.position().SetXYZT(
+	    planPosition_.X() + planMomentum_.X()/planMomentum_.E()*timeC,
+	    planPosition_.Y() + planMomentum_.Y()/planMomentum_.E()*timeC,
+	    planPosition_.Z() + planMomentum_.Z()/planMomentum_.E()*timeC,
+	    planPosition_.T() + timeC / fastsim::Constants::speedOfLight);
+	lastCrossingTimeC_ = timeC;
+	lastPosition_ = particle.position();
+
+	if(decays)
+	{
+	    LogDebug(MESSAGECATEGORY) << "    moved particle to its decay point";
+	    particle.setRemainingProperLifeTime(0.);
+	    exitState_ = DECAYED;
+	    return false;
+	}
+	layer = crossing.layer;
+	LogDebug(MESSAGECATEGORY) << "    moved particle to layer: " << *layer;
+	return true;
+    }
+
+    // all crossings inside the tracker volume are done
+    LogDebug(MESSAGECATEGORY) << "    success: 0";
+    exitState_ = planLeavesVolume_ ? ESCAPED : NOCROSSING;
+    return false;
+}
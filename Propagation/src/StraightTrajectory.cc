@@ -4,9 +4,26 @@
 #include "FastSimulation/Layer/interface/BarrelLayer.h"
 #include "FastSimulation/Layer/interface/ForwardLayer.h"
 
+#include <algorithm>
+
+bool fastsim::StraightTrajectory::staysOutside(double radius) const
+{
+    // outside and not moving inwards: the distance to the z axis only grows
+    return position_.Perp2() >= radius*radius
+	&& position_.X()*momentum_.X() + position_.Y()*momentum_.Y() >= 0;
+}
+
 double fastsim::StraightTrajectory::nextCrossingTimeC(const fastsim::BarrelLayer & layer) const
 {
-    if(layer.isOnSurface(position_))
+    double a = momentum_.Perp2();
+    double b = (position_.X()*momentum_.X() + position_.Y()*momentum_.Y() );
+
+    // particle on the layer:
+    // one solution is the current position, the other one (t*c = -2*b/a * E for a particle exactly on the layer) is only ahead if the particle moves inwards
+    // the particle is on the layer within the on-surface tolerance only: the exact solution is used below,
+    // for lines that graze the layer, the two solutions are close and c does matter
+    bool onSurface = layer.isOnSurface(position_);
+    if(onSurface && !(a > 0 && b < 0))
     {
 	   return -1;
     }
@@ -31,11 +48,14 @@ double fastsim::StraightTrajectory::nextCrossingTimeC(const fastsim::BarrelLayer
     // with a = p_x^2 + p_y^2
     // with b = p_x*x_0 + p_y*y_0
     // with c = x_0^2 + y_0^2 - R^2
-    double a = momentum_.Perp2();
-    double b = (position_.X()*momentum_.X() + position_.Y()*momentum_.Y() );
     double c = position_.Perp2() - layer.getRadius()*layer.getRadius();
 
     double delta = b*b - a*c;
+    if(onSurface)
+    {
+	   // the later solution, the earlier one being the current position
+	   return (-b + sqrt(std::max(delta,0.)))/a*momentum_.E();
+    }
     if(delta < 0)
     {
 	   return -1;
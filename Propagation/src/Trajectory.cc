@@ -1,6 +1,5 @@
 #include "DataFormats/Math/interface/LorentzVector.h"
-#include "FastSimulation/Propagation/interface/StraightTrajectory.h"
-#include "FastSimulation/Propagation/interface/HelixTrajectory.h"
+#include "FastSimulation/Propagation/interface/Trajectory.h"
 #include "FastSimulation/Layer/interface/ForwardLayer.h"
 #include "FastSimulation/Layer/interface/BarrelLayer.h"
 #include "FastSimulation/NewParticle/interface/Particle.h"
@@ -15,25 +14,6 @@ fastsim::Trajectory::Trajectory(const fastsim::Particle & particle)
     momentum_ = particle.momentum();
 }
 
-std::unique_ptr<fastsim::Trajectory> fastsim::Trajectory::createTrajectory(const fastsim::Particle & particle,double magneticFieldZ)
-{
-    if(particle.charge() == 0. || magneticFieldZ == 0.)
-    {
-	   LogDebug("FastSim") << "create straight trajectory";
-	   return std::unique_ptr<fastsim::Trajectory>(new fastsim::StraightTrajectory(particle));
-    }
-    else if(std::abs(particle.momentum().Pt() / (speedOfLight_ * 1e-4 * particle.charge() * magneticFieldZ)) > 1e8){
-       LogDebug("FastSim") << "create straight trajectory (huge radius)";
-       return std::unique_ptr<fastsim::Trajectory>(new fastsim::StraightTrajectory(particle));
-    }
-    else
-    {
-	   LogDebug("FastSim") << "create helix trajectory";
-	   return std::unique_ptr<fastsim::Trajectory>(new fastsim::HelixTrajectory(particle,magneticFieldZ));
-    }
-}
-
-
 double fastsim::Trajectory::nextCrossingTimeC(const fastsim::Layer & layer) const
 {
     if(layer.isForward())
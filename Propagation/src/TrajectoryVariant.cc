@@ -0,0 +1,37 @@
+#include "FastSimulation/Propagation/interface/TrajectoryVariant.h"
+#include "FastSimulation/NewParticle/interface/Particle.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include <new>
+
+fastsim::Trajectory & fastsim::TrajectoryVariant::set(const fastsim::Particle & particle,double magneticFieldZ)
+{
+    reset();
+    isHelix_ = false;
+    if(particle.charge() == 0. || magneticFieldZ == 0.)
+    {
+	   LogDebug("FastSim") << "create straight trajectory";
+	   trajectory_ = new (&storage_) fastsim::StraightTrajectory(particle);
+    }
+    else if(std::abs(particle.momentum().Pt() / (Trajectory::speedOfLight_ * 1e-4 * particle.charge() * magneticFieldZ)) > 1e8){
+       LogDebug("FastSim") << "create straight trajectory (huge radius)";
+       trajectory_ = new (&storage_) fastsim::StraightTrajectory(particle);
+    }
+    else
+    {
+	   LogDebug("FastSim") << "create helix trajectory";
+	   trajectory_ = new (&storage_) fastsim::HelixTrajectory(particle,magneticFieldZ);
+	   isHelix_ = true;
+    }
+    return *trajectory_;
+}
+
+void fastsim::TrajectoryVariant::reset()
+{
+    if(trajectory_)
+    {
+	trajectory_->~Trajectory();
+	trajectory_ = 0;
+	isHelix_ = false;
+    }
+}
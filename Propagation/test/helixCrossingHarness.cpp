@@ -0,0 +1,309 @@
+// accuracy and speed of HelixTrajectory::nextCrossingTimeC (circle-circle intersection)
+// compared to the solver it replaced (quadratic equation in sin(phi), copied below as OldHelix)
+// both are checked against an independent long double reference over random helices:
+//    - pT log-uniform in [0.05,1000] GeV, charge +-1, B = 3.8 T, pions
+//    - start inside the tracker (r < 110 cm), or exactly on the layer (1 in 5)
+//    - layer radius uniform in [2,120] cm
+// usage: helixCrossingHarness [number of helices, default 2000000]
+
+#include "FastSimulation/Propagation/interface/HelixTrajectory.h"
+#include "FastSimulation/Layer/interface/BarrelLayer.h"
+#include "FastSimulation/NewParticle/interface/Particle.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const double speedOfLight = 29.9792458; // cm / ns
+    const double magneticFieldZ = 3.8;
+    const double pionMass = 0.13957;
+
+    struct Helix
+    {
+	double x, y, px, py, pz, e, charge, layerR;
+    };
+
+    // the former solver of HelixTrajectory: a quadratic equation in sin(phi),
+    // with a small angle approximation when its roots miss the layer by more than 10 microns
+    // (diagnostic output replaced by a counter, layer replaced by its radius)
+    struct OldHelix
+    {
+	static unsigned long nApproximations;
+
+	OldHelix(const Helix & h)
+	    : x_(h.x), y_(h.y), px_(h.px), py_(h.py), e_(h.e)
+	    , radius_(std::abs(std::sqrt(h.px*h.px + h.py*h.py) / (speedOfLight * 1e-4 * h.charge * magneticFieldZ)))
+	    , phi_(std::atan(h.py/h.px) + (h.px*h.charge < 0 ? 3.*M_PI/2. : M_PI/2. ))
+	    , centerX_(h.x - radius_ * (h.py/h.px) / std::sqrt((h.py/h.px)*(h.py/h.px)+1) * (h.px*h.charge < 0 ? 1. : -1.))
+	    , centerY_(h.y - radius_ * 1 / std::sqrt((h.py/h.px)*(h.py/h.px)+1) * (h.px*h.charge < 0 ? -1. : 1.))
+	    , centerR_(std::sqrt(centerX_*centerX_ + centerY_*centerY_))
+	    , minR_(centerR_ - radius_)
+	    , maxR_(centerR_ + radius_)
+	    , phiSpeed_(-h.charge * magneticFieldZ * speedOfLight * speedOfLight * 1e-4 / h.e)
+	{}
+
+	bool crosses(double layerR) const { return minR_ < layerR && maxR_ > layerR; }
+
+	double r(double phi) const
+	{
+	    return std::sqrt((centerX_ + radius_*std::cos(phi))*(centerX_ + radius_*std::cos(phi)) + (centerY_ + radius_*std::sin(phi))*(centerY_ + radius_*std::sin(phi)));
+	}
+
+	double nextCrossingTimeC(double layerR) const
+	{
+	    if(!crosses(layerR)) return -1;
+	    bool doApproximation = (radius_ > 5000 ? true : false);
+	    if(!doApproximation)
+	    {
+		double E = centerX_*centerX_ + centerY_*centerY_ + radius_*radius_ - layerR*layerR;
+		double F = 2*centerY_*radius_;
+		double G = 2*centerX_*radius_;
+		double a = F*F + G*G;
+		double b = 2*E*F;
+		double c = E*E - G*G;
+		double delta = b*b - 4*a*c;
+		if(delta < 0)
+		{
+		    throw cms::Exception("fastsim::HelixTrajectory::nextCrossingTimeC") << "should not be reached";
+		}
+		double sqrtDelta = sqrt(delta);
+		double phi1 = std::asin((-b - sqrtDelta) / (2.*a));
+		double phi2 = std::asin((-b + sqrtDelta) / (2.*a));
+		if(std::abs(layerR - r(phi1)) > 1e-3) phi1 = - phi1 + M_PI;
+		if(std::abs(layerR - r(phi2)) > 1e-3) phi2 = - phi2 + M_PI;
+		if(phi1 < 0) phi1 += 2. * M_PI;
+		if(phi2 < 0) phi2 += 2. * M_PI;
+		if(std::abs(layerR - r(phi1)) > 1e-3 || std::abs(layerR - r(phi2)) > 1e-3)
+		{
+		    doApproximation = true;
+		    ++nApproximations;
+		}
+		if(!doApproximation)
+		{
+		    double t1 = (phi1 - phi_)/phiSpeed_;
+		    while(t1 < 0) t1 += 2*M_PI/std::abs(phiSpeed_);
+		    double t2 = (phi2 - phi_)/phiSpeed_;
+		    while(t2 < 0) t2 += 2*M_PI/std::abs(phiSpeed_);
+		    if(std::abs(phi1 - phi_)*radius_ < 1e-3) return t2*speedOfLight;
+		    if(std::abs(phi2 - phi_)*radius_ < 1e-3) return t1*speedOfLight;
+		    return std::min(t1,t2)*speedOfLight;
+		}
+	    }
+	    double c = (centerX_ + radius_ * std::cos(phi_))*(centerX_ + radius_ * std::cos(phi_)) + (centerY_ + radius_ * std::sin(phi_))*(centerY_ + radius_ * std::sin(phi_)) - layerR*layerR;
+	    double b = 2 * radius_ * (centerY_ * std::cos(phi_) - centerX_ * std::sin(phi_));
+	    double a = radius_ * radius_;
+	    double delta = b*b - 4*a*c;
+	    if(delta < 0) return -1.;
+	    double sqrtDelta = sqrt(delta);
+	    double delPhi1 = std::asin((-b - sqrtDelta) / (2.*a));
+	    double delPhi2 = std::asin((-b + sqrtDelta) / (2.*a));
+	    double delPhi;
+	    bool twoSolutions = false;
+	    if(phiSpeed_ > 0)
+	    {
+		if(delPhi1 > 0 && delPhi2 > 0) { delPhi = std::min(delPhi1, delPhi2); twoSolutions = true; }
+		else if(delPhi1 > 0) delPhi = delPhi1;
+		else delPhi = delPhi2;
+	    }
+	    else
+	    {
+		if(delPhi1 < 0 && delPhi2 < 0) { delPhi = std::max(delPhi1, delPhi2); twoSolutions = true; }
+		else if(delPhi1 < 0) delPhi = delPhi1;
+		else delPhi = delPhi2;
+	    }
+	    if(std::abs(delPhi)*radius_ < 1e-3)
+	    {
+		if(twoSolutions)
+		{
+		    if(delPhi == delPhi1 && std::abs(delPhi2) < 1e-2) return delPhi2 / phiSpeed_ * speedOfLight;
+		    else if(delPhi == delPhi2 && std::abs(delPhi1) < 1e-2) return delPhi1 / phiSpeed_ * speedOfLight;
+		}
+		return -1;
+	    }
+	    if(std::abs(delPhi) > 1) return -1;
+	    return delPhi / phiSpeed_ * speedOfLight;
+	}
+
+	double x_, y_, px_, py_, e_;
+	double radius_, phi_, centerX_, centerY_, centerR_, minR_, maxR_, phiSpeed_;
+    };
+    unsigned long OldHelix::nApproximations = 0;
+
+    // independent reference in long double: intersection points of the two circles,
+    // and phase advance from the current position to each of them
+    struct Reference
+    {
+	Reference(const Helix & h)
+	{
+	    long double pT = std::sqrt((long double)h.px*h.px + (long double)h.py*h.py);
+	    radius = pT / std::abs((long double)speedOfLight * 1e-4L * h.charge * magneticFieldZ);
+	    omega = -h.charge * magneticFieldZ * (long double)speedOfLight * speedOfLight * 1e-4L / h.e;
+	    direction = omega > 0 ? 1 : -1;
+	    ux = direction * h.py / pT;
+	    uy = -direction * h.px / pT;
+	    cx = h.x - radius * ux;
+	    cy = h.y - radius * uy;
+	}
+
+	// time*c of the next crossing, -1 if none
+	// (as HelixTrajectory, crossings less than 10 microns of arc away are ignored)
+	long double nextCrossingTimeC(long double layerR) const
+	{
+	    long double d = std::sqrt(cx*cx + cy*cy);
+	    if(d == 0 || d + radius <= layerR || std::abs(d - radius) >= layerR) return -1;
+	    long double a = (d*d + radius*radius - layerR*layerR) / (2*d);
+	    long double h = std::sqrt(std::max(radius*radius - a*a,0.0L));
+	    long double ex = -cx/d, ey = -cy/d;
+	    long double best = -1;
+	    for(int sign = -1;sign <= 1;sign += 2)
+	    {
+		long double vx = a*ex - sign*h*ey, vy = a*ey + sign*h*ex;
+		long double phase = std::atan2(ux*vy - uy*vx, ux*vx + uy*vy) * direction;
+		if(phase < 0) phase += 2*M_PIl;
+		if(phase*radius < 1e-3L || (2*M_PIl - phase)*radius < 1e-3L) continue;
+		if(best < 0 || phase < best) best = phase;
+	    }
+	    return best < 0 ? -1 : best / std::abs(omega) * speedOfLight;
+	}
+
+	// distance of the helix from the layer after a time*c
+	long double residual(long double timeC,long double layerR) const
+	{
+	    long double phase = direction * std::abs(omega) * timeC / speedOfLight;
+	    long double x = cx + radius*(ux*std::cos(phase) - uy*std::sin(phase));
+	    long double y = cy + radius*(uy*std::cos(phase) + ux*std::sin(phase));
+	    return std::sqrt(x*x + y*y) - layerR;
+	}
+
+	// arc length between two times*c
+	long double arc(long double timeC1,long double timeC2) const
+	{
+	    return std::abs(omega) * std::abs(timeC1 - timeC2) / speedOfLight * radius;
+	}
+
+	long double radius, omega, ux, uy, cx, cy;
+	int direction;
+    };
+
+    struct Summary
+    {
+	unsigned long missed = 0;      // no crossing returned, but there is one
+	unsigned long spurious = 0;    // crossing returned, but there is none
+	unsigned long wrong = 0;       // not the next crossing (more than 1 micron of arc away)
+	unsigned long exceptions = 0;
+	std::vector<double> residuals; // |r - R_L| at the returned crossing [cm]
+
+	void add(const Reference & reference,double layerR,double timeC,double referenceTimeC)
+	{
+	    if(referenceTimeC < 0 && timeC >= 0) ++spurious;
+	    else if(referenceTimeC >= 0 && timeC < 0) ++missed;
+	    else if(timeC >= 0)
+	    {
+		if(reference.arc(timeC,referenceTimeC) > 1e-4) ++wrong;
+		residuals.push_back(std::abs((double)reference.residual(timeC,layerR)));
+	    }
+	}
+
+	void print(const char * name,unsigned long n)
+	{
+	    std::sort(residuals.begin(),residuals.end());
+	    auto quantile = [this](double q) {return residuals.empty() ? 0. : residuals[std::min<size_t>(residuals.size() - 1,q * residuals.size())];};
+	    std::printf("%-4s missed %lu (%.2e)  spurious %lu (%.2e)  wrong crossing %lu (%.2e)  exceptions %lu\n",
+			name,missed,double(missed)/n,spurious,double(spurious)/n,wrong,double(wrong)/n,exceptions);
+	    std::printf("     |r - R_layer| [cm]: median %.2e  99.9%% %.2e  max %.2e\n",
+			quantile(0.5),quantile(0.999),residuals.empty() ? 0. : residuals.back());
+	}
+    };
+}
+
+int main(int argc,char ** argv)
+{
+    unsigned long n = argc > 1 ? std::strtoul(argv[1],0,10) : 2000000;
+
+    std::mt19937_64 engine(12345);
+    std::uniform_real_distribution<double> uniform(0.,1.);
+    std::vector<Helix> helices(n);
+    for(Helix & h : helices)
+    {
+	double pT = 0.05 * std::pow(1000. / 0.05,uniform(engine));
+	double phi = 2. * M_PI * uniform(engine);
+	double eta = 5. * uniform(engine) - 2.5;
+	h.px = pT * std::cos(phi);
+	h.py = pT * std::sin(phi);
+	h.pz = pT * std::sinh(eta);
+	h.e = std::sqrt(pT*pT + h.pz*h.pz + pionMass*pionMass);
+	h.charge = uniform(engine) < 0.5 ? -1. : 1.;
+	h.layerR = 2. + 118. * uniform(engine);
+	double r = uniform(engine) < 0.2 ? h.layerR : 110. * std::sqrt(uniform(engine));
+	double positionPhi = 2. * M_PI * uniform(engine);
+	h.x = r * std::cos(positionPhi);
+	h.y = r * std::sin(positionPhi);
+    }
+
+    // accuracy
+    Summary oldSummary, newSummary;
+    for(const Helix & h : helices)
+    {
+	Reference reference(h);
+	double referenceTimeC = reference.nextCrossingTimeC(h.layerR);
+
+	fastsim::Particle particle(211,math::XYZTLorentzVector(h.x,h.y,0.,0.),math::XYZTLorentzVector(h.px,h.py,h.pz,h.e));
+	particle.setCharge(h.charge);
+	fastsim::BarrelLayer layer(h.layerR);
+	newSummary.add(reference,h.layerR,fastsim::HelixTrajectory(particle,magneticFieldZ).nextCrossingTimeC(layer),referenceTimeC);
+
+	try
+	{
+	    oldSummary.add(reference,h.layerR,OldHelix(h).nextCrossingTimeC(h.layerR),referenceTimeC);
+	}
+	catch(const cms::Exception &)
+	{
+	    ++oldSummary.exceptions;
+	}
+    }
+    std::printf("%lu helices\n",n);
+    oldSummary.print("old",n);
+    std::printf("     (old: %lu fallbacks to the small angle approximation)\n",OldHelix::nApproximations);
+    newSummary.print("new",n);
+
+    // speed: construction and one crossing
+    std::vector<fastsim::Particle> particles;
+    std::vector<std::unique_ptr<fastsim::BarrelLayer> > layers;
+    particles.reserve(n);
+    layers.reserve(n);
+    for(const Helix & h : helices)
+    {
+	particles.emplace_back(211,math::XYZTLorentzVector(h.x,h.y,0.,0.),math::XYZTLorentzVector(h.px,h.py,h.pz,h.e));
+	particles.back().setCharge(h.charge);
+	layers.emplace_back(new fastsim::BarrelLayer(h.layerR));
+    }
+    double sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(const Helix & h : helices)
+    {
+	try
+	{
+	    sum += OldHelix(h).nextCrossingTimeC(h.layerR);
+	}
+	catch(const cms::Exception &) {}
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for(unsigned long index = 0;index < n;++index)
+    {
+	sum += fastsim::HelixTrajectory(particles[index],magneticFieldZ).nextCrossingTimeC(*layers[index]);
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::printf("construction + crossing: old %.1f ns  new %.1f ns  (checksum %g)\n",
+		std::chrono::duration<double,std::nano>(middle - start).count() / n,
+		std::chrono::duration<double,std::nano>(end - middle).count() / n,
+		sum);
+    return 0;
+}
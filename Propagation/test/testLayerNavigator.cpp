@@ -0,0 +1,457 @@
+#include "FastSimulation/Geometry/interface/SyntheticGeometry.h"
+#include "FastSimulation/Layer/interface/BarrelLayer.h"
+#include "FastSimulation/Layer/interface/ForwardLayer.h"
+#include "FastSimulation/NewParticle/interface/Particle.h"
+#include "FastSimulation/Propagation/interface/LayerNavigator.h"
+#include "FastSimulation/Propagation/interface/StraightTrajectory.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const double magneticFieldZ = 3.8;
+    const double pionMass = 0.13957;
+
+    // a pi+ at r = 13 cm, between BPix3 (10.177 cm) and the pixel support (17.6 cm)
+    // its helix (radius 1.75 cm, center at r = 14.75 cm) reaches neither of them,
+    // the next layer is the forward layer at z = 28.799 cm, a bit more than one turn away
+    fastsim::Particle makeLooper()
+    {
+	double pT = 0.02, pz = 0.05;
+	fastsim::Particle particle(211,
+				   math::XYZTLorentzVector(13.,0.,0.,0.),
+				   math::XYZTLorentzVector(0.,pT,pz,std::sqrt(pT*pT + pz*pz + pionMass*pionMass)));
+	particle.setCharge(1.);
+	particle.setStable();
+	return particle;
+    }
+
+    // t*c of one turn, see LayerNavigator
+    double timeCPerTurn(const fastsim::Particle & particle)
+    {
+	return 2. * M_PI * particle.momentum().E() / (29.9792458 * 1e-4 * magneticFieldZ);
+    }
+
+    // t*c to the forward layer at z = 28.799 cm
+    double timeCToForwardLayer(const fastsim::Particle & particle)
+    {
+	return 28.799 * particle.momentum().E() / particle.momentum().Pz();
+    }
+
+    // a neutral particle from the origin, in the x-z plane
+    fastsim::Particle makeNeutral(int pdgId,double mass,double p,double eta)
+    {
+	double pT = p / std::cosh(eta), pz = pT * std::sinh(eta);
+	fastsim::Particle particle(pdgId,
+				   math::XYZTLorentzVector(0.,0.,0.,0.),
+				   math::XYZTLorentzVector(pT,0.,pz,std::sqrt(p*p + mass*mass)));
+	particle.setCharge(0.);
+	return particle;
+    }
+
+    // moves the particle through all layers, returns the number of layers crossed
+    unsigned countSteps(fastsim::LayerNavigator & navigator,fastsim::Particle & particle)
+    {
+	unsigned nSteps = 0;
+	const fastsim::Layer * layer = 0;
+	while(navigator.moveParticleToNextLayer(particle,layer))
+	{
+	    ++nSteps;
+	}
+	return nSteps;
+    }
+
+    // a charged pion from the beam spot, 0.3 - 5 GeV, |eta| < 2.5
+    fastsim::Particle makePion(std::mt19937 & engine)
+    {
+	std::uniform_real_distribution<double> flat(0.,1.);
+	double phi = 2.*M_PI*flat(engine), eta = 5.*flat(engine) - 2.5, pT = 0.3 + 4.7*flat(engine);
+	double pz = pT*std::sinh(eta);
+	fastsim::Particle particle(211,
+				   math::XYZTLorentzVector(0.1*flat(engine) - 0.05,0.1*flat(engine) - 0.05,10.*flat(engine) - 5.,0.),
+				   math::XYZTLorentzVector(pT*std::cos(phi),pT*std::sin(phi),pz,std::sqrt(pT*pT + pz*pz + pionMass*pionMass)));
+	particle.setCharge(flat(engine) < 0.5 ? 1. : -1.);
+	particle.setStable();
+	return particle;
+    }
+
+    // without magnetic field, charged particles follow straight lines with the step-wise navigation, neutral particles with the plan
+    // (see LayerNavigator::planStraightLine): a charged and a neutral copy of the same particle must cross the same layers,
+    // at the same positions, and stop for the same reason
+    void expectSameStraightLineNavigation(const fastsim::Geometry & geometry,const fastsim::Particle & particle)
+    {
+	fastsim::Particle neutral(particle), charged(particle);
+	neutral.setCharge(0.);
+	charged.setCharge(1.);
+	fastsim::LayerNavigator planNavigator(geometry), stepNavigator(geometry);
+	const fastsim::Layer * planLayer = 0, * stepLayer = 0;
+	const double tolerance = 1e-6;
+	for(unsigned step = 0;;++step)
+	{
+	    bool planMoved = planNavigator.moveParticleToNextLayer(neutral,planLayer);
+	    bool stepMoved = stepNavigator.moveParticleToNextLayer(charged,stepLayer);
+	    ASSERT_EQ(planMoved,stepMoved) << "step " << step;
+	    if(!planMoved)
+	    {
+		ASSERT_EQ(planNavigator.exitState(),stepNavigator.exitState());
+		return;
+	    }
+	    ASSERT_EQ(planLayer,stepLayer) << "step " << step;
+	    ASSERT_NEAR(neutral.position().X(),charged.position().X(),tolerance) << "step " << step;
+	    ASSERT_NEAR(neutral.position().Y(),charged.position().Y(),tolerance) << "step " << step;
+	    ASSERT_NEAR(neutral.position().Z(),charged.position().Z(),tolerance) << "step " << step;
+	}
+    }
+
+    class LayerNavigatorTest : public ::testing::Test
+    {
+    protected:
+	LayerNavigatorTest() : geometry_(fastsim::test::syntheticGeometry(fastsim::test::syntheticGeometryConfig(magneticFieldZ))) {}
+	std::unique_ptr<fastsim::Geometry> geometry_;
+    };
+}
+
+TEST_F(LayerNavigatorTest, LooperReachesForwardLayerWithoutBudget)
+{
+    fastsim::Particle particle = makeLooper();
+    double turns = timeCToForwardLayer(particle) / timeCPerTurn(particle);
+    ASSERT_GT(turns,1.);
+    ASSERT_LT(turns,2.);
+
+    fastsim::LayerNavigator navigator(*geometry_);
+    const fastsim::Layer * layer = 0;
+    ASSERT_TRUE(navigator.moveParticleToNextLayer(particle,layer));
+    ASSERT_TRUE(layer != 0);
+    EXPECT_TRUE(layer->isForward());
+    EXPECT_NEAR(static_cast<const fastsim::ForwardLayer *>(layer)->getZ(),28.799,1e-9);
+    EXPECT_NEAR(particle.position().Z(),28.799,1e-6);
+}
+
+TEST_F(LayerNavigatorTest, LooperBudgetStopsLooper)
+{
+    fastsim::Particle particle = makeLooper();
+    math::XYZTLorentzVector position = particle.position();
+
+    fastsim::LayerNavigator navigator(*geometry_);
+    navigator.setMaxLooperTurns(0.5);
+    const fastsim::Layer * layer = 0;
+    EXPECT_FALSE(navigator.moveParticleToNextLayer(particle,layer));
+    EXPECT_EQ(navigator.exitState(),fastsim::LayerNavigator::LOOPERSTOPPED);
+    EXPECT_TRUE(layer == 0);
+    // the particle is not moved
+    EXPECT_EQ(particle.position(),position);
+}
+
+TEST_F(LayerNavigatorTest, LooperBudgetLeavesLifeTimeOfStoppedLooper)
+{
+    // the looper would decay after 0.75 turns, before reaching the forward layer,
+    // but the budget of 0.5 turns stops it first: it must not be flagged as decayed (remaining life time 0)
+    fastsim::Particle particle = makeLooper();
+    double gamma = particle.gamma();
+    double remainingProperLifeTime = 0.75 * timeCPerTurn(particle) / gamma;
+    particle.setRemainingProperLifeTime(remainingProperLifeTime);
+
+    fastsim::LayerNavigator navigator(*geometry_);
+    navigator.setMaxLooperTurns(0.5);
+    const fastsim::Layer * layer = 0;
+    EXPECT_FALSE(navigator.moveParticleToNextLayer(particle,layer));
+    EXPECT_EQ(navigator.exitState(),fastsim::LayerNavigator::LOOPERSTOPPED);
+    EXPECT_DOUBLE_EQ(particle.remainingProperLifeTime(),remainingProperLifeTime);
+}
+
+TEST_F(LayerNavigatorTest, LooperDecaysWithinBudget)
+{
+    // the looper decays after 0.75 turns, within the budget of 0.9 turns
+    fastsim::Particle particle = makeLooper();
+    particle.setRemainingProperLifeTime(0.75 * timeCPerTurn(particle) / particle.gamma());
+    math::XYZTLorentzVector position = particle.position();
+
+    fastsim::LayerNavigator navigator(*geometry_);
+    navigator.setMaxLooperTurns(0.9);
+    const fastsim::Layer * layer = 0;
+    EXPECT_FALSE(navigator.moveParticleToNextLayer(particle,layer));
+    EXPECT_EQ(navigator.exitState(),fastsim::LayerNavigator::DECAYED);
+    EXPECT_EQ(particle.remainingProperLifeTime(),0.);
+    EXPECT_NE(particle.position(),position);
+}
+
+TEST_F(LayerNavigatorTest, PhotonEscapes)
+{
+    // at eta = 0.3, the photon leaves the volume through the last barrel layer (r = 120 cm, z = 36.5 cm),
+    // after the 17 barrel layers and the forward layers at z = 28.799, 28.8 and 34.5 cm
+    fastsim::Particle particle = makeNeutral(22,0.,10.,0.3);
+    particle.setStable();
+
+    fastsim::LayerNavigator navigator(*geometry_);
+    EXPECT_EQ(countSteps(navigator,particle),20u);
+    EXPECT_EQ(navigator.exitState(),fastsim::LayerNavigator::ESCAPED);
+    EXPECT_NEAR(particle.position().Rho(),120.,1e-6);
+}
+
+TEST_F(LayerNavigatorTest, K0SEscapesBeforeDecay)
+{
+    // the decay is checked on each step: the K0S decays on a step longer than 20 cm (t*c of 20 cm along the line),
+    // longer than any step inside the volume (at most 12.5 cm, from r = 108 to 120 cm),
+    // but shorter than the step beyond it, to the infinite plane of the forward layer at z = 46.5 cm (r = 153 cm)
+    fastsim::Particle particle = makeNeutral(310,0.497611,1.,0.3);
+    double remainingProperLifeTime = 20. * particle.momentum().E() / particle.momentum().P() / particle.gamma();
+    particle.setRemainingProperLifeTime(remainingProperLifeTime);
+
+    fastsim::LayerNavigator navigator(*geometry_);
+    EXPECT_EQ(countSteps(navigator,particle),20u);
+    EXPECT_EQ(navigator.exitState(),fastsim::LayerNavigator::ESCAPED);
+    EXPECT_DOUBLE_EQ(particle.remainingProperLifeTime(),remainingProperLifeTime);
+    EXPECT_NEAR(particle.position().Rho(),120.,1e-6);
+}
+
+TEST_F(LayerNavigatorTest, K0SDecaysInside)
+{
+    // the same K0S, decaying at r = 2 cm, before the first layer
+    fastsim::Particle particle = makeNeutral(310,0.497611,1.,0.3);
+    double timeCToDecay = 2. * std::cosh(0.3) * particle.momentum().E() / particle.momentum().P();
+    particle.setRemainingProperLifeTime(timeCToDecay / particle.gamma());
+
+    fastsim::LayerNavigator navigator(*geometry_);
+    EXPECT_EQ(countSteps(navigator,particle),0u);
+    EXPECT_EQ(navigator.exitState(),fastsim::LayerNavigator::DECAYED);
+    EXPECT_EQ(particle.remainingProperLifeTime(),0.);
+    EXPECT_NEAR(particle.position().Rho(),2.,1e-6);
+}
+
+TEST(LayerNavigator, StraightLinePlanMatchesStepWiseNavigation)
+{
+    // random lines, including lines with crossings of a barrel and a forward layer within the on-surface tolerance of each other
+    std::unique_ptr<fastsim::Geometry> geometry = fastsim::test::syntheticGeometry(fastsim::test::syntheticGeometryConfig(0.));
+    std::mt19937 engine(1234);
+    std::uniform_real_distribution<double> flat(0.,1.);
+    for(unsigned line = 0;line < 20000;++line)
+    {
+	// vertices with r < 60 cm and |z| < 100 cm, isotropic directions
+	double r = 60.*std::sqrt(flat(engine)), phi = 2.*M_PI*flat(engine), z = 200.*flat(engine) - 100.;
+	double cosTheta = 2.*flat(engine) - 1., sinTheta = std::sqrt(1. - cosTheta*cosTheta), phiMomentum = 2.*M_PI*flat(engine);
+	fastsim::Particle particle(211,
+				   math::XYZTLorentzVector(r*std::cos(phi),r*std::sin(phi),z,0.),
+				   math::XYZTLorentzVector(sinTheta*std::cos(phiMomentum),sinTheta*std::sin(phiMomentum),cosTheta,std::sqrt(1. + pionMass*pionMass)));
+	particle.setStable();
+	SCOPED_TRACE(line);
+	expectSameStraightLineNavigation(*geometry,particle);
+	if(HasFatalFailure())
+	{
+	    return;
+	}
+    }
+}
+
+TEST(LayerNavigator, StartLayerOnBetweenAndBeyondLayers)
+{
+    // the enclosing layers of a new particle are found by binary search (see LayerNavigator::moveParticleToNextCrossing),
+    // the plan of the neutral copy does not depend on them: particles starting on the layers (within the on-surface tolerance or just outside it),
+    // between them, inside the innermost and beyond the outermost layer, moving inwards and outwards
+    std::unique_ptr<fastsim::Geometry> geometry = fastsim::test::syntheticGeometry(fastsim::test::syntheticGeometryConfig(0.));
+    const double epsilonR = fastsim::Layer::epsilonDistanceR_, epsilonZ = fastsim::Layer::epsilonDistanceZ_;
+    const double offsets[] = {-3.,-0.5,0.,0.5,3.};
+
+    std::vector<double> radii = {0.5,130.};
+    for(unsigned index = 0;index < geometry->barrelLayers().size();++index)
+    {
+	double radius = geometry->barrelLayers()[index]->getRadius();
+	for(double offset : offsets)
+	{
+	    radii.push_back(radius + offset*epsilonR);
+	}
+	if(index + 1 < geometry->barrelLayers().size())
+	{
+	    radii.push_back(0.5*(radius + geometry->barrelLayers()[index + 1]->getRadius()));
+	}
+    }
+    for(double radius : radii)
+    {
+	for(double px : {-1.,-0.3,0.3,1.})
+	{
+	    fastsim::Particle particle(211,
+				       math::XYZTLorentzVector(radius,0.,10.,0.),
+				       math::XYZTLorentzVector(px,0.5,0.4,std::sqrt(px*px + 0.41 + pionMass*pionMass)));
+	    particle.setStable();
+	    SCOPED_TRACE(testing::Message() << "r = " << radius << ", px = " << px);
+	    expectSameStraightLineNavigation(*geometry,particle);
+	}
+    }
+
+    std::vector<double> zs = {-320.,0.,320.};
+    for(unsigned index = 0;index < geometry->forwardLayers().size();++index)
+    {
+	double z = geometry->forwardLayers()[index]->getZ();
+	for(double offset : offsets)
+	{
+	    zs.push_back(z + offset*epsilonZ);
+	    zs.push_back(-z - offset*epsilonZ);
+	}
+	if(index + 1 < geometry->forwardLayers().size())
+	{
+	    zs.push_back(0.5*(z + geometry->forwardLayers()[index + 1]->getZ()));
+	}
+    }
+    for(double z : zs)
+    {
+	for(double pz : {-1.,1.})
+	{
+	    fastsim::Particle particle(211,
+				       math::XYZTLorentzVector(30.,20.,z,0.),
+				       math::XYZTLorentzVector(0.2,0.1,pz,std::sqrt(pz*pz + 0.05 + pionMass*pionMass)));
+	    particle.setStable();
+	    SCOPED_TRACE(testing::Message() << "z = " << z << ", pz = " << pz);
+	    expectSameStraightLineNavigation(*geometry,particle);
+	}
+    }
+}
+
+TEST_F(LayerNavigatorTest, StraightTrajectoryOnBarrelLayer)
+{
+    // TIB1, r = 25.767 cm
+    const fastsim::BarrelLayer & layer = *geometry_->barrelLayers()[5];
+    double radius = layer.getRadius();
+    const double alpha = 0.3;
+    fastsim::Particle particle(22,
+			       math::XYZTLorentzVector(radius,0.,0.,0.),
+			       math::XYZTLorentzVector(-std::cos(alpha),std::sin(alpha),1.,std::sqrt(2.)));
+
+    // on the layer, moving inwards: the other side of the layer, a chord of 2*r*cos(alpha) further
+    EXPECT_NEAR(fastsim::StraightTrajectory(particle).nextCrossingTimeC(layer),2.*radius*std::cos(alpha)*std::sqrt(2.),1e-9);
+
+    // on the layer, moving outwards: no crossing ahead
+    particle.momentum().SetXYZT(std::cos(alpha),std::sin(alpha),1.,std::sqrt(2.));
+    EXPECT_EQ(fastsim::StraightTrajectory(particle).nextCrossingTimeC(layer),-1.);
+
+    // on the layer within the on-surface tolerance, grazing it inwards:
+    // the particle is moved exactly onto the layer, not a chord of the nominal length further
+    particle.position().SetXYZT(radius + 0.5 * fastsim::Layer::epsilonDistanceR_,0.,0.,0.);
+    particle.momentum().SetXYZT(-0.01,1.,1.,std::sqrt(2.0001));
+    ASSERT_TRUE(layer.isOnSurface(particle.position()));
+    fastsim::StraightTrajectory trajectory(particle);
+    double timeC = trajectory.nextCrossingTimeC(layer);
+    ASSERT_GT(timeC,0.);
+    trajectory.move(timeC);
+    EXPECT_NEAR(trajectory.getPosition().Rho(),radius,1e-9);
+}
+
+TEST_F(LayerNavigatorTest, NewParticleOnLayerCurlsBack)
+{
+    // a soft pi+ created on TOB1 (r = 60.937 cm), moving outwards: its helix (radius 3.5 cm) turns back before the next layer,
+    // the first crossing is TOB1 again
+    const fastsim::BarrelLayer & layer = *geometry_->barrelLayers()[10];
+    double pT = 0.04, pz = 0.01;
+    fastsim::Particle particle(211,
+			       math::XYZTLorentzVector(layer.getRadius(),0.,0.,0.),
+			       math::XYZTLorentzVector(pT*std::cos(0.5),pT*std::sin(0.5),pz,std::sqrt(pT*pT + pz*pz + pionMass*pionMass)));
+    particle.setCharge(1.);
+    particle.setStable();
+
+    fastsim::LayerNavigator navigator(*geometry_);
+    const fastsim::Layer * nextLayer = 0;
+    ASSERT_TRUE(navigator.moveParticleToNextLayer(particle,nextLayer));
+    EXPECT_EQ(nextLayer,&layer);
+    EXPECT_GT(particle.position().T(),0.);
+    EXPECT_NEAR(particle.position().Rho(),layer.getRadius(),1e-6);
+}
+
+TEST_F(LayerNavigatorTest, RelevanceMaskGivesSameCrossings)
+{
+    // the navigator with relevance masks must stop on the relevant layers only, exactly where the navigator without masks crosses them
+    std::vector<bool> barrelLayerIsRelevant(geometry_->barrelLayers().size()), forwardLayerIsRelevant(geometry_->forwardLayers().size());
+    for(unsigned index = 0;index < barrelLayerIsRelevant.size();++index)
+    {
+	barrelLayerIsRelevant[index] = index % 2 == 0;
+    }
+    for(unsigned index = 0;index < forwardLayerIsRelevant.size();++index)
+    {
+	forwardLayerIsRelevant[index] = index % 3 == 0;
+    }
+
+    std::mt19937 engine(4321);
+    for(unsigned i = 0;i < 1000;++i)
+    {
+	fastsim::Particle particle = makePion(engine);
+	// (every fourth particle neutral, on the straight line plan)
+	if(i % 4 == 0)
+	{
+	    particle.setCharge(0.);
+	}
+	fastsim::Particle skippingParticle(particle);
+
+	// all crossings, the relevant ones are kept
+	std::vector<std::pair<const fastsim::Layer *,math::XYZTLorentzVector> > relevantCrossings;
+	fastsim::LayerNavigator navigator(*geometry_);
+	const fastsim::Layer * layer = 0;
+	while(navigator.moveParticleToNextLayer(particle,layer))
+	{
+	    if((layer->isForward() ? forwardLayerIsRelevant : barrelLayerIsRelevant)[layer->index()])
+	    {
+		relevantCrossings.emplace_back(layer,particle.position());
+	    }
+	}
+
+	fastsim::LayerNavigator skippingNavigator(*geometry_,barrelLayerIsRelevant,forwardLayerIsRelevant);
+	const fastsim::Layer * skippingLayer = 0;
+	unsigned nCrossings = 0;
+	while(skippingNavigator.moveParticleToNextLayer(skippingParticle,skippingLayer))
+	{
+	    ASSERT_LT(nCrossings,relevantCrossings.size()) << "particle " << i;
+	    EXPECT_EQ(skippingLayer,relevantCrossings[nCrossings].first) << "particle " << i << ", crossing " << nCrossings;
+	    EXPECT_EQ(skippingParticle.position(),relevantCrossings[nCrossings].second) << "particle " << i << ", crossing " << nCrossings;
+	    ++nCrossings;
+	}
+	EXPECT_EQ(nCrossings,relevantCrossings.size()) << "particle " << i;
+	EXPECT_EQ(skippingNavigator.exitState(),navigator.exitState()) << "particle " << i;
+    }
+}
+
+TEST_F(LayerNavigatorTest, ContinuationAfterInteraction)
+{
+    // the trajectory of the previous step is continued as long as the particle is not modified:
+    // each step must give the same crossing as a new navigator started from the particle on the layer,
+    // also after an interaction (here: every third step, the momentum is scaled and turned)
+    std::mt19937 engine(5678);
+    for(unsigned i = 0;i < 300;++i)
+    {
+	fastsim::Particle particle = makePion(engine);
+	fastsim::LayerNavigator navigator(*geometry_);
+	const fastsim::Layer * layer = 0;
+	for(unsigned step = 0;;++step)
+	{
+	    if(step % 3 == 2)
+	    {
+		const math::XYZTLorentzVector & momentum = particle.momentum();
+		double c = std::cos(0.2), s = std::sin(0.2);
+		double px = 0.8*(c*momentum.X() - s*momentum.Y()), py = 0.8*(s*momentum.X() + c*momentum.Y()), pz = 0.8*momentum.Z();
+		particle.momentum().SetXYZT(px,py,pz,std::sqrt(px*px + py*py + pz*pz + pionMass*pionMass));
+	    }
+
+	    fastsim::Particle newParticle(particle);
+	    fastsim::LayerNavigator newNavigator(*geometry_);
+	    const fastsim::Layer * newLayer = 0;
+	    bool newMoved = newNavigator.moveParticleToNextLayer(newParticle,newLayer);
+
+	    bool moved = navigator.moveParticleToNextLayer(particle,layer);
+	    // (the time cut is only applied to particles on a layer: not to the new navigator)
+	    if(!moved && navigator.exitState() == fastsim::LayerNavigator::OUTOFTIME)
+	    {
+		break;
+	    }
+	    ASSERT_EQ(moved,newMoved) << "particle " << i << ", step " << step;
+	    if(!moved)
+	    {
+		EXPECT_EQ(navigator.exitState(),newNavigator.exitState()) << "particle " << i;
+		break;
+	    }
+	    ASSERT_EQ(layer,newLayer) << "particle " << i << ", step " << step;
+	    EXPECT_NEAR(particle.position().X(),newParticle.position().X(),1e-6) << "particle " << i << ", step " << step;
+	    EXPECT_NEAR(particle.position().Y(),newParticle.position().Y(),1e-6) << "particle " << i << ", step " << step;
+	    EXPECT_NEAR(particle.position().Z(),newParticle.position().Z(),1e-6) << "particle " << i << ", step " << step;
+	    EXPECT_NEAR(particle.momentum().Phi(),newParticle.momentum().Phi(),1e-9) << "particle " << i << ", step " << step;
+	}
+    }
+}
@@ -1,4 +1,4 @@
-#include "FastSimulation/Utilities/interface/RandomEngineAndDistribution.h"
+#include "CLHEP/Random/RandomEngine.h"
 #include "FastSimulation/NewParticle/interface/Particle.h"
 #include "FastSimulation/Layer/interface/Layer.h"
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
@@ -20,15 +20,17 @@ namespace fastsim
     {
     public:
 	Bremsstrahlung(const std::string & name,const edm::ParameterSet & cfg);
-	void interact(Particle & particle,const Layer & layer,std::vector<std::unique_ptr<Particle> > & secondaries,const RandomEngineAndDistribution & random);
+	void interact(Particle & particle,const Layer & layer,std::vector<std::unique_ptr<Particle> > & secondaries,CLHEP::HepRandomEngine & random);
+	// only electrons and positrons radiate
+	bool canAct(ParticleClass particleClass,const Layer & layer) const override {return particleClass == ELECTRON;}
     private:
-	math::XYZTLorentzVector brem(Particle & particle , double xmin,const RandomEngineAndDistribution & random) const;
+	math::XYZTLorentzVector brem(Particle & particle , double xmin,CLHEP::HepRandomEngine & random) const;
 	double gbteth(const double ener,
 		      const double partm,
 		      const double efrac,
-		      const RandomEngineAndDistribution & random) const ;
+		      CLHEP::HepRandomEngine & random) const ;
 	// why do we have a dedicated implementation here? check it, probably it can go...
-	unsigned int poisson(double ymu, const RandomEngineAndDistribution & random);
+	unsigned int poisson(double ymu, CLHEP::HepRandomEngine & random);
 	double minPhotonEnergy_;
 	double minPhotonEnergyFraction_;
     };
@@ -43,7 +45,7 @@ fastsim::Bremsstrahlung::Bremsstrahlung(const std::string & name,const edm::Para
 }
 
 
-void fastsim::Bremsstrahlung::interact(fastsim::Particle & particle, const Layer & layer,std::vector<std::unique_ptr<fastsim::Particle> > & secondaries,const RandomEngineAndDistribution & random)
+void fastsim::Bremsstrahlung::interact(fastsim::Particle & particle, const Layer & layer,std::vector<std::unique_ptr<fastsim::Particle> > & secondaries,CLHEP::HepRandomEngine & random)
 {
     // only consider electrons and positrons
     if(abs(particle.pdgId())!=11)
@@ -108,7 +110,7 @@ void fastsim::Bremsstrahlung::interact(fastsim::Particle & particle, const Layer
 
 
 math::XYZTLorentzVector
-fastsim::Bremsstrahlung::brem(fastsim::Particle & particle , double xmin,const RandomEngineAndDistribution & random) const 
+fastsim::Bremsstrahlung::brem(fastsim::Particle & particle , double xmin,CLHEP::HepRandomEngine & random) const 
 {
 
     // This is a simple version (a la PDG) of a Brem generator.
@@ -119,16 +121,16 @@ fastsim::Bremsstrahlung::brem(fastsim::Particle & particle , double xmin,const R
     double weight = 0.;
   
     do {
-	xp = xmin * std::exp ( -std::log(xmin) * random.flatShoot() );
+	xp = xmin * std::exp ( -std::log(xmin) * random.flat() );
 	weight = 1. - xp + 3./4.*xp*xp;
-    } while ( weight < random.flatShoot() );
+    } while ( weight < random.flat() );
   
   
     // Have photon energy. Now generate angles with respect to the z axis 
     // defined by the incoming particle's momentum.
 
     // Isotropic in phi
-    const double phi = random.flatShoot()*2*M_PI;
+    const double phi = random.flat()*2*M_PI;
     // theta from universal distribution
     const double theta = gbteth(particle.momentum().E(),emass,xp,random)*emass/particle.momentum().E();
   
@@ -146,7 +148,7 @@ double
 fastsim::Bremsstrahlung::gbteth(const double ener,
 				const double partm,
 				const double efrac,
-                                const RandomEngineAndDistribution & random) const 
+                                CLHEP::HepRandomEngine & random) const 
 {
     const double alfa = 0.625;
     
@@ -158,8 +160,8 @@ fastsim::Bremsstrahlung::gbteth(const double ener,
     
     do 
     {
-	double beta = (random.flatShoot()<=w1) ? alfa : 3.0*alfa;
-	u = -std::log(random.flatShoot()*random.flatShoot())/beta;
+	double beta = (random.flat()<=w1) ? alfa : 3.0*alfa;
+	u = -std::log(random.flat()*random.flat())/beta;
     } 
     while (u>=umax);
 
@@ -168,12 +170,12 @@ fastsim::Bremsstrahlung::gbteth(const double ener,
 
 
 unsigned int 
-fastsim::Bremsstrahlung::poisson(double ymu, const RandomEngineAndDistribution & random) 
+fastsim::Bremsstrahlung::poisson(double ymu, CLHEP::HepRandomEngine & random) 
 {
     unsigned int n = 0;
     double prob = std::exp(-ymu);
     double proba = prob;
-    double x = random.flatShoot();
+    double x = random.flat();
     
     while ( proba <= x ) {
 	prob *= ymu / double(++n);
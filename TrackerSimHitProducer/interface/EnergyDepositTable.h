@@ -0,0 +1,56 @@
+#ifndef FASTSIM_ENERGYDEPOSITTABLE_H
+#define FASTSIM_ENERGYDEPOSITTABLE_H
+
+#include <vector>
+
+namespace fastsim
+{
+    // energy deposit of a charged particle on a short path through silicon, sampled from a Landau distribution
+    //    - most probable value and width (xi) from Bichsel, see the PDG review "Passage of particles through matter"
+    //    - the deposit is mpv + xi * (lambda - lambda_mpv), with lambda from the standard Landau distribution
+    // everything that does not depend on the random number is tabulated at construction,
+    // such that a deposit is sampled in constant time:
+    //    - the inverse of the cumulative Landau distribution, on a uniform grid in probability
+    //      (and on a finer grid within its first bin, to follow the steep low tail)
+    //    - the most probable value and the width, on a uniform grid in log10(beta*gamma) and log10(path length)
+    // the tables are interpolated linearly, values outside the grids are clamped to the grids
+    // (beyond plateauBetaGamma the clamping is exact: on the Fermi plateau the deposit does not depend on beta*gamma)
+    // validity:
+    //    - the Landau distribution holds for kappa = xi / W_max < 0.01 (W_max: largest energy transfer to an electron, ~ 2 m_e (beta*gamma)^2)
+    //      for 300 microns of silicon, that is beta*gamma > 1 (kappa = 0.7 at beta*gamma = 0.3)
+    //      below, the true (Vavilov) distribution is narrower: the Landau tail overestimates the fluctuations of slow hadrons
+    //    - below minBetaGamma, Bethe and Landau do not apply, and the range of the particle is at most the thickness of a module:
+    //      the particle is taken to stop, and deposits its kinetic energy
+    class EnergyDepositTable
+    {
+    public:
+	EnergyDepositTable();
+
+	// energy deposit [GeV] of a particle with charge +-1 and kinetic energy kineticEnergy [GeV] on a path of length pathLength [cm],
+	// u: uniform random number in [0,1)
+	// (xi, the only dependence on the path length, is proportional to charge^2 * pathLength:
+	// for other charges, use charge^2 * pathLength)
+	// the deposit is at most the kinetic energy
+	double sample(double betaGamma,double pathLength,double kineticEnergy,double u) const;
+
+	// most probable value and width (xi) of the deposit [GeV], as used by sample
+	double mostProbableValue(double betaGamma,double pathLength) const;
+	double width(double betaGamma,double pathLength) const;
+
+	static const double minBetaGamma;
+	// beta*gamma of particles without mass
+	static const double plateauBetaGamma;
+
+    private:
+	void interpolate(double betaGamma,double pathLength,double & mostProbableValue,double & width) const;
+
+	std::vector<double> landauQuantiles_;
+	// within the first bin of landauQuantiles_
+	std::vector<double> landauLowTailQuantiles_;
+	// by log10(beta*gamma) (outer) and log10(path length) (inner)
+	std::vector<double> mostProbableValues_;
+	std::vector<double> widths_;
+    };
+}
+
+#endif
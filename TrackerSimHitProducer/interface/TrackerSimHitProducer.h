@@ -0,0 +1,90 @@
+#ifndef FASTSIM_TRACKERSIMHITPRODUCER_H
+#define FASTSIM_TRACKERSIMHITPRODUCER_H
+
+#include <vector>
+#include <memory>
+#include <map>
+#include <utility>
+#include <string>
+
+#include "FastSimulation/InteractionModel/interface/InteractionModel.h"
+#include "FastSimulation/Layer/interface/Layer.h"
+#include "FastSimulation/TrackerSimHitProducer/interface/EnergyDepositTable.h"
+#include "DataFormats/GeometryVector/interface/GlobalPoint.h"
+#include "DataFormats/GeometryVector/interface/LocalPoint.h"
+#include "DataFormats/GeometryVector/interface/LocalVector.h"
+#include "SimDataFormats/TrackingHit/interface/PSimHit.h"
+#include "SimDataFormats/TrackingHit/interface/PSimHitContainer.h"
+
+class GeomDet;
+class GlobalTrajectoryParameters;
+class UniformMagneticField;
+
+namespace edm
+{
+    class ParameterSet;
+}
+
+namespace fastsim
+{
+    class ModuleIndex;
+
+    class TrackerSimHitProducer : public InteractionModel
+    {
+    public:
+	TrackerSimHitProducer(const std::string & name,const edm::ParameterSet & cfg);
+	~TrackerSimHitProducer();
+	void interact(Particle & particle,const Layer & layer,std::vector<std::unique_ptr<Particle> > & secondaries,CLHEP::HepRandomEngine & random) override;
+	// hits are only created on layers with tracker modules
+	bool canAct(ParticleClass particleClass,const Layer & layer) const override {return layer.getDetLayer() != 0;}
+	virtual void registerProducts(edm::ProducerBase & producer) const override;
+	virtual void storeProducts(edm::Event & iEvent) override;
+	virtual void appendProducts(InteractionModel & other,int simTrackIndexOffset) override;
+	// creates the hits of the particle on the modules of a layer, in the order they are crossed, at the end of simHits()
+	void createHits(const Particle & particle,const ModuleIndex & moduleIndex,bool isForward,double magneticFieldZ,CLHEP::HepRandomEngine & random);
+	// creates the hit of the particle on the detector (if any) in distAndHits_, together with its distance to refPos
+	bool createHitOnDetector(const GlobalTrajectoryParameters & particle,double betaGamma,double kineticEnergy,int pdgId,int simTrackId,const GeomDet & detector,const GlobalPoint & refPos,CLHEP::HepRandomEngine & random);
+	// hits created since the last storeProducts
+	const edm::PSimHitContainer & simHits() const {return *simHitContainer_;}
+    private:
+	const UniformMagneticField & magneticField(double magneticFieldZ);
+	// crossings of the particle's helix with the planes of the candidate modules (moduleIndices_), in crossings_
+	// (batched scalar solver, see the .cc)
+	void crossModules(const GlobalTrajectoryParameters & particle,const ModuleIndex & moduleIndex);
+	// adds the hit of a particle crossing the detector at localPosition (hitPosition in global coordinates)
+	void addHit(double charge,double betaGamma,double kineticEnergy,int pdgId,int simTrackId,const GeomDet & detector,const LocalPoint & localPosition,const LocalVector & localMomentum,const GlobalPoint & hitPosition,const GlobalPoint & refPos,CLHEP::HepRandomEngine & random);
+	const float onSurfaceTolerance_;
+	// margin of the search window for modules [cm], in addition to the bending of the trajectory
+	const double moduleSearchTolerance_;
+	// crossings further than this from the module plane [cm] are recomputed with HelixArbitraryPlaneCrossing
+	const double crossingTolerance_;
+	const unsigned newtonIterations_;
+	// energy deposit in the modules
+	const EnergyDepositTable energyDepositTable_;
+	// the magnetic field of a layer is a lookup table (see Layer::getMagneticFieldZ):
+	// only a limited number of field values occur, each gets its field object once
+	std::map<double,std::unique_ptr<UniformMagneticField> > magneticFields_;
+	// candidate modules of the current layer (see ModuleIndex), reused for all layers
+	std::vector<unsigned> moduleIndices_;
+	// crossings with the candidate modules, by position in moduleIndices_, reused for all layers
+	struct Crossings
+	{
+	    void resize(unsigned size);
+	    // crossing point
+	    std::vector<double> x, y, z;
+	    // crossing point and direction (unit vector) in the coordinate system of the module
+	    std::vector<double> localX, localY, localZ;
+	    std::vector<double> localDirectionX, localDirectionY, localDirectionZ;
+	    // the crossing point is on the plane (within crossingTolerance_)
+	    std::vector<unsigned char> converged;
+	    // the crossing point is within the bounds of the module
+	    std::vector<unsigned char> inBounds;
+	};
+	Crossings crossings_;
+	std::unique_ptr<edm::PSimHitContainer> simHitContainer_;
+	// hits of the current layer with their distance to the reference position, reused for all layers
+	std::vector<std::pair<double,PSimHit> > distAndHits_;
+    };
+}
+
+#endif
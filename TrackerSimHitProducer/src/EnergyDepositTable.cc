@@ -0,0 +1,154 @@
+#include "FastSimulation/TrackerSimHitProducer/interface/EnergyDepositTable.h"
+
+#include "Math/QuantFuncMathCore.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // silicon
+    const double electronMass = 0.510998928e-3; // GeV
+    const double meanExcitationEnergy = 173e-9; // GeV
+    const double xiPerLength = 0.5 * 0.307075e-3 * 14. / 28.0855 * 2.329; // K/2 * Z/A * density [GeV/cm]
+    const double bichselJ = 0.200;
+    // density effect correction (Sternheimer, Berger, Seltzer 1984)
+    const double densityC = 4.4351;
+    const double densityX0 = 0.2014;
+    const double densityX1 = 2.8715;
+    const double densityA = 0.14921;
+    const double densityK = 3.2546;
+    const double densityDelta0 = 0.14;
+
+    // most probable value of the standard Landau distribution
+    const double landauMostProbableValue = -0.22278;
+
+    // grids
+    // (the Landau tail is cut at maxProbability)
+    const unsigned nProbabilities = 1000;
+    const double maxProbability = 0.999;
+    // (from minBetaGamma to plateauBetaGamma)
+    const unsigned nBetaGammas = 100;
+    const double minLog10BetaGamma = -1.;
+    const double maxLog10BetaGamma = 4.;
+    const unsigned nPathLengths = 80;
+    const double minLog10PathLength = -3.; // 10 microns
+    const double maxLog10PathLength = 1.;  // 10 cm
+
+    double densityEffect(double log10BetaGamma)
+    {
+	if(log10BetaGamma >= densityX1)
+	{
+	    return 2. * std::log(10.) * log10BetaGamma - densityC;
+	}
+	if(log10BetaGamma >= densityX0)
+	{
+	    return 2. * std::log(10.) * log10BetaGamma - densityC + densityA * std::pow(densityX1 - log10BetaGamma,densityK);
+	}
+	return densityDelta0 * std::pow(10.,2. * (log10BetaGamma - densityX0));
+    }
+
+    // position of x on a uniform grid of n bins in [min,max]: bin (clamped to the grid) and fraction in the bin
+    void gridPosition(double x,double min,double max,unsigned n,unsigned & bin,double & fraction)
+    {
+	double position = std::min(std::max((x - min) / (max - min) * n,0.),double(n));
+	bin = std::min(unsigned(position),n - 1);
+	fraction = position - bin;
+    }
+}
+
+const double fastsim::EnergyDepositTable::minBetaGamma = 0.1;
+const double fastsim::EnergyDepositTable::plateauBetaGamma = 1e4;
+
+fastsim::EnergyDepositTable::EnergyDepositTable()
+{
+    landauQuantiles_.resize(nProbabilities + 1);
+    landauLowTailQuantiles_.resize(nProbabilities + 1);
+    for(unsigned index = 0;index <= nProbabilities;++index)
+    {
+	// (the quantile of probability 0 is -infinity: start the grids at half a bin)
+	double probability = std::max(double(index),0.5) * maxProbability / nProbabilities;
+	landauQuantiles_[index] = ROOT::Math::landau_quantile(probability) - landauMostProbableValue;
+	landauLowTailQuantiles_[index] = ROOT::Math::landau_quantile(probability / nProbabilities) - landauMostProbableValue;
+    }
+
+    mostProbableValues_.resize((nBetaGammas + 1) * (nPathLengths + 1));
+    widths_.resize((nBetaGammas + 1) * (nPathLengths + 1));
+    for(unsigned betaGammaIndex = 0;betaGammaIndex <= nBetaGammas;++betaGammaIndex)
+    {
+	double log10BetaGamma = minLog10BetaGamma + (maxLog10BetaGamma - minLog10BetaGamma) * betaGammaIndex / nBetaGammas;
+	double betaGamma2 = std::pow(10.,2. * log10BetaGamma);
+	double beta2 = betaGamma2 / (1. + betaGamma2);
+	for(unsigned pathLengthIndex = 0;pathLengthIndex <= nPathLengths;++pathLengthIndex)
+	{
+	    double pathLength = std::pow(10.,minLog10PathLength + (maxLog10PathLength - minLog10PathLength) * pathLengthIndex / nPathLengths);
+	    double xi = xiPerLength * pathLength / beta2;
+	    unsigned index = betaGammaIndex * (nPathLengths + 1) + pathLengthIndex;
+	    widths_[index] = xi;
+	    mostProbableValues_[index] = xi * (std::log(2. * electronMass * betaGamma2 / meanExcitationEnergy)
+					       + std::log(xi / meanExcitationEnergy)
+					       + bichselJ - beta2 - densityEffect(log10BetaGamma));
+	}
+    }
+}
+
+double fastsim::EnergyDepositTable::sample(double betaGamma,double pathLength,double kineticEnergy,double u) const
+{
+    // too slow for Landau (see the header): the particle stops in the module
+    // (the particle itself is not stopped here, energy loss is left to the material effects)
+    if(betaGamma < minBetaGamma)
+    {
+	return kineticEnergy;
+    }
+
+    unsigned probabilityBin;
+    double probabilityFraction;
+    gridPosition(u * maxProbability,0.,maxProbability,nProbabilities,probabilityBin,probabilityFraction);
+    // (the first bin, where the quantile falls off steeply, from the finer grid)
+    const std::vector<double> & quantiles = probabilityBin == 0 ? landauLowTailQuantiles_ : landauQuantiles_;
+    if(probabilityBin == 0)
+    {
+	gridPosition(probabilityFraction,0.,1.,nProbabilities,probabilityBin,probabilityFraction);
+    }
+    double lambda = (1. - probabilityFraction) * quantiles[probabilityBin] + probabilityFraction * quantiles[probabilityBin + 1];
+
+    double mostProbableValue = 0, width = 0;
+    interpolate(betaGamma,pathLength,mostProbableValue,width);
+    return std::min(kineticEnergy,std::max(0.,mostProbableValue + width * lambda));
+}
+
+double fastsim::EnergyDepositTable::mostProbableValue(double betaGamma,double pathLength) const
+{
+    double mostProbableValue = 0, width = 0;
+    interpolate(betaGamma,pathLength,mostProbableValue,width);
+    return mostProbableValue;
+}
+
+double fastsim::EnergyDepositTable::width(double betaGamma,double pathLength) const
+{
+    double mostProbableValue = 0, width = 0;
+    interpolate(betaGamma,pathLength,mostProbableValue,width);
+    return width;
+}
+
+void fastsim::EnergyDepositTable::interpolate(double betaGamma,double pathLength,double & mostProbableValue,double & width) const
+{
+    unsigned betaGammaBin, pathLengthBin;
+    double betaGammaFraction, pathLengthFraction;
+    gridPosition(std::log10(betaGamma),minLog10BetaGamma,maxLog10BetaGamma,nBetaGammas,betaGammaBin,betaGammaFraction);
+    gridPosition(std::log10(pathLength),minLog10PathLength,maxLog10PathLength,nPathLengths,pathLengthBin,pathLengthFraction);
+
+    unsigned index = betaGammaBin * (nPathLengths + 1) + pathLengthBin;
+    double weights[4] = {(1. - betaGammaFraction) * (1. - pathLengthFraction),
+			 (1. - betaGammaFraction) * pathLengthFraction,
+			 betaGammaFraction * (1. - pathLengthFraction),
+			 betaGammaFraction * pathLengthFraction};
+    unsigned indices[4] = {index,index + 1,index + nPathLengths + 1,index + nPathLengths + 2};
+    mostProbableValue = 0;
+    width = 0;
+    for(unsigned corner = 0;corner < 4;++corner)
+    {
+	mostProbableValue += weights[corner] * mostProbableValues_[indices[corner]];
+	width += weights[corner] * widths_[indices[corner]];
+    }
+}
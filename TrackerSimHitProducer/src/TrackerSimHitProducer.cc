@@ -0,0 +1,375 @@
+#include "FastSimulation/TrackerSimHitProducer/interface/TrackerSimHitProducer.h"
+
+#include <algorithm>
+#include <tuple>
+#include <cmath>
+
+// framework
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/ProducerBase.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "MagneticField/UniformEngine/src/UniformMagneticField.h"
+
+// tracking
+#include "TrackingTools/TrajectoryParametrization/interface/GlobalTrajectoryParameters.h"
+#include "TrackingTools/GeomPropagators/interface/HelixArbitraryPlaneCrossing.h"
+#include "DataFormats/TrajectorySeed/interface/PropagationDirection.h"
+
+// fastsim
+#include "FastSimulation/NewParticle/interface/Particle.h"
+#include "FastSimulation/Layer/interface/ModuleIndex.h"
+#include "CLHEP/Random/RandomEngine.h"
+
+// data formats
+#include "DataFormats/GeometrySurface/interface/Plane.h"
+#include "DataFormats/GeometryVector/interface/GlobalVector.h"
+#include "DataFormats/Math/interface/deltaPhi.h"
+
+// other
+#include "Geometry/CommonDetUnit/interface/GeomDet.h"
+#include "CondFormats/External/interface/DetID.h"
+
+fastsim::TrackerSimHitProducer::TrackerSimHitProducer(const std::string & name,const edm::ParameterSet & cfg)
+    : fastsim::InteractionModel(name)
+    , onSurfaceTolerance_(0.01) // 10 microns // hm, sure this is not 100 microns?
+    , moduleSearchTolerance_(0.1)
+    , crossingTolerance_(cfg.getUntrackedParameter<double>("crossingTolerance",1e-4)) // 1 micron
+    , newtonIterations_(3)
+    , simHitContainer_(new edm::PSimHitContainer)
+{}
+
+fastsim::TrackerSimHitProducer::~TrackerSimHitProducer()
+{;}
+
+void fastsim::TrackerSimHitProducer::registerProducts(edm::ProducerBase & producer) const
+{
+    producer.produces<edm::PSimHitContainer>("TrackerHits");
+}
+
+void fastsim::TrackerSimHitProducer::storeProducts(edm::Event & iEvent)
+{
+    //std::cout << "Number of Hits: " << simHitContainer_->size() << std::endl;
+    //for(auto shit : *(simHitContainer_.get())){
+    //  std::cout<<shit.detUnitId()<<": "<<shit.localPosition().x()<<","<<shit.localPosition().y()<<std::endl;
+    //}
+    iEvent.put(std::move(simHitContainer_), "TrackerHits");
+    simHitContainer_.reset(new edm::PSimHitContainer);
+}
+
+void fastsim::TrackerSimHitProducer::appendProducts(InteractionModel & other,int simTrackIndexOffset)
+{
+    edm::PSimHitContainer & otherSimHits = *static_cast<TrackerSimHitProducer &>(other).simHitContainer_;
+    for(const PSimHit & hit : otherSimHits)
+    {
+	simHitContainer_->emplace_back(hit.entryPoint(),hit.exitPoint(),hit.pabs(),hit.tof(),hit.energyLoss(),hit.particleType(),
+				       hit.detUnitId(),hit.trackId() + simTrackIndexOffset,hit.thetaAtEntry(),hit.phiAtEntry(),hit.processType());
+    }
+    otherSimHits.clear();
+}
+
+const UniformMagneticField & fastsim::TrackerSimHitProducer::magneticField(double magneticFieldZ)
+{
+    std::unique_ptr<UniformMagneticField> & entry = magneticFields_[magneticFieldZ];
+    if(!entry)
+    {
+	entry.reset(new UniformMagneticField(magneticFieldZ));
+    }
+    return *entry;
+}
+
+void fastsim::TrackerSimHitProducer::interact(Particle & particle,const Layer & layer,std::vector<std::unique_ptr<Particle> > & secondaries,CLHEP::HepRandomEngine & random)
+{
+    //
+    // check that layer has tracker modules
+    //
+    if(!layer.getModuleIndex())
+    {
+	return;
+    }
+    createHits(particle,*layer.getModuleIndex(),layer.isForward(),layer.getMagneticFieldZ(particle.position()),random);
+}
+
+void fastsim::TrackerSimHitProducer::createHits(const Particle & particle,const ModuleIndex & moduleIndex,bool isForward,double magneticFieldZ,CLHEP::HepRandomEngine & random)
+{
+    //
+    // create the trajectory of the particle
+    //
+    GlobalPoint  position( particle.position().X(), particle.position().Y(), particle.position().Z());
+    GlobalVector momentum( particle.momentum().Px(), particle.momentum().Py(), particle.momentum().Pz());
+    GlobalTrajectoryParameters trajectory( position, momentum, TrackCharge( particle.charge()), &magneticField(magneticFieldZ));
+    
+    //
+    // find the modules the particle can cross:
+    // the modules around the straight line through the particle's position,
+    // over the path length needed to traverse the modules of the layer (in w, see ModuleIndex),
+    // with a margin for the bending of the trajectory along that path
+    //
+    double x0 = position.x(), y0 = position.y(), z0 = position.z();
+    double dx = momentum.x()/momentum.mag(), dy = momentum.y()/momentum.mag(), dz = momentum.z()/momentum.mag();
+    double w0 = isForward ? z0 : position.perp();
+    double dw = isForward ? dz : (x0*dx + y0*dy)/w0;
+    // (for tracks nearly parallel to the layer, the window is limited to 20 times the thickness of the layer)
+    double pathLength = std::max(moduleIndex.maxW() - w0,w0 - moduleIndex.minW()) / std::max(std::abs(dw),0.05);
+    double margin = moduleSearchTolerance_ + pathLength*pathLength*std::abs(trajectory.transverseCurvature())/2.;
+    GlobalPoint begin(x0 - pathLength*dx,y0 - pathLength*dy,z0 - pathLength*dz);
+    GlobalPoint end(x0 + pathLength*dx,y0 + pathLength*dy,z0 + pathLength*dz);
+    // smallest distance to the z axis on the straight line between begin and end
+    double dT2 = dx*dx + dy*dy;
+    double closest = dT2 > 0 ? std::max(-pathLength,std::min(pathLength,-(x0*dx + y0*dy)/dT2)) : 0;
+    double minR = std::sqrt((x0 + closest*dx)*(x0 + closest*dx) + (y0 + closest*dy)*(y0 + closest*dy));
+    double maxR = std::max(begin.perp(),end.perp());
+    // phi changes monotonically along the line, from begin through the particle's position to end
+    double phi0 = position.phi();
+    double deltaPhiBegin = reco::deltaPhi(double(begin.phi()),phi0);
+    double deltaPhiEnd = reco::deltaPhi(double(end.phi()),phi0);
+    double phiMin = -M_PI, phiMax = M_PI;
+    if(minR > 2.*margin)
+    {
+	phiMin = phi0 + std::min(0.,std::min(deltaPhiBegin,deltaPhiEnd)) - margin/minR;
+	phiMax = phi0 + std::max(0.,std::max(deltaPhiBegin,deltaPhiEnd)) + margin/minR;
+    }
+    double uMin = isForward ? minR - margin : std::min(begin.z(),end.z()) - margin;
+    double uMax = isForward ? maxR + margin : std::max(begin.z(),end.z()) + margin;
+    moduleIndices_.clear();
+    moduleIndex.candidates(phiMin,phiMax,uMin,uMax,moduleIndices_);
+
+    ////////
+    // You have to sort the simHits in the order they occur!
+    ////////
+
+    // The old algorithm (sorting by distance to IP) doesn't seem to make sense to me (what if particle moves inwards??)
+
+    // Detector layers have to be sorted by proximity to particle.position
+    // Doesn't always work! Particle could be already have been propagated in between the layers!
+    // Proximity to previous hit also doesn't work since simHits only store the localPosition
+    // Propagate particle backwards a bit to make sure it's outside any components (straight line should work well enough) 
+    distAndHits_.clear();
+    // Position relative to which the hits should be sorted
+    GlobalPoint positionOutside(particle.position().x()-particle.momentum().x()/particle.momentum().mag()*10.,
+                                particle.position().y()-particle.momentum().y()/particle.momentum().mag()*10.,
+                                particle.position().z()-particle.momentum().z()/particle.momentum().mag()*10.);
+    // beta*gamma and kinetic energy, for the energy deposit (see EnergyDepositTable)
+    // particles without mass (or whose mass is lost to rounding, M() of an ultrarelativistic particle) are on the Fermi plateau
+    double mass = particle.momentum().M();
+    double betaGamma = mass > 0 ? momentum.mag()/mass : EnergyDepositTable::plateauBetaGamma;
+    double kineticEnergy = particle.momentum().E() - std::max(mass,0.);
+
+    //
+    // cross all candidate modules at once, then create the hits on the modules that are hit
+    //
+    crossModules(trajectory,moduleIndex);
+    for(unsigned i = 0;i < moduleIndices_.size();++i)
+    {
+	const GeomDet & module = moduleIndex.module(moduleIndices_[i]);
+	// (rare) no crossing found: use the tracking tools
+	if(!crossings_.converged[i])
+	{
+	    createHitOnDetector(trajectory,betaGamma,kineticEnergy,particle.pdgId(),particle.simTrackIndex(),module,positionOutside,random);
+	}
+	else if(crossings_.inBounds[i])
+	{
+	    addHit(particle.charge(),betaGamma,kineticEnergy,particle.pdgId(),particle.simTrackIndex(),module,
+		   LocalPoint(crossings_.localX[i],crossings_.localY[i],crossings_.localZ[i]),
+		   LocalVector(crossings_.localDirectionX[i],crossings_.localDirectionY[i],crossings_.localDirectionZ[i])*momentum.mag(),
+		   GlobalPoint(crossings_.x[i],crossings_.y[i],crossings_.z[i]),
+		   positionOutside,random);
+	}
+    }
+
+    // Fill simHitContainer, ordered by distance
+    // (hits at the same distance are kept, in the order they were created)
+    // (insertion sort: a layer gives a few hits, and std::stable_sort would allocate a buffer for each layer)
+    for(unsigned i = 1;i < distAndHits_.size();++i)
+    {
+	for(unsigned j = i;j > 0 && distAndHits_[j].first < distAndHits_[j - 1].first;--j)
+	{
+	    std::swap(distAndHits_[j],distAndHits_[j - 1]);
+	}
+    }
+    // (no reserve: reserving the exact size for each layer would defeat the geometric growth of the container)
+    for(const auto & distAndHit : distAndHits_){
+    	simHitContainer_->push_back(distAndHit.second);
+    }
+    
+}
+
+// Also stores the distance to the simHit since hits have to be ordered (in time) afterwards
+bool fastsim::TrackerSimHitProducer::createHitOnDetector(const GlobalTrajectoryParameters & particle, double betaGamma, double kineticEnergy, int pdgId, int simTrackId, const GeomDet & detector, const GlobalPoint & refPos, CLHEP::HepRandomEngine & random)
+{
+    //
+    // determine position and momentum of particle in the coordinate system of the detector
+    //
+    LocalPoint localPosition;
+    LocalVector localMomentum;
+    // if the particle is close enough, no further propagation is needed
+    localPosition = detector.toLocal(particle.position());
+    if ( fabs( localPosition.z()) < onSurfaceTolerance_) 
+    {
+	   localMomentum = detector.toLocal(particle.momentum());
+    }
+    // else, propagate 
+    else 
+    {
+    	// find crossing of particle with 
+    	HelixArbitraryPlaneCrossing crossing(particle.position().basicVector(),
+    					      particle.momentum().basicVector(),
+    					      particle.transverseCurvature(),
+    					      anyDirection);
+    	std::pair<bool,double> path = crossing.pathLength(detector.surface());
+    	// case propagation succeeds
+    	if (path.first) 	
+    	{
+    	    localPosition = detector.toLocal( GlobalPoint( crossing.position(path.second)));
+    	    localMomentum = detector.toLocal( GlobalVector( crossing.direction(path.second)));
+    	    localMomentum = localMomentum.unit() * particle.momentum().mag();
+    	}
+    	// case propagation fails
+    	else
+    	{
+    	    return false;
+    	}
+    }
+
+    //
+    // make sure the simhit is physically on the module
+    //
+    const Plane& detectorPlane = detector.surface();
+    double boundX = detectorPlane.bounds().width()/2.;
+    double boundY = detectorPlane.bounds().length()/2.;
+    // Special treatment for TID and TEC trapeziodal modules
+    unsigned subdet = DetId(detector.geographicalId()).subdetId(); 
+    if ( subdet == 4 || subdet == 6 ) 
+	boundX *=  1. - localPosition.y()/detectorPlane.position().perp();
+    if(fabs(localPosition.x()) > boundX  || fabs(localPosition.y()) > boundY )
+    {
+       //std::cout<<"Hit position (id: " << detector.geographicalId().rawId() << "; " << simTrackId << ")= out of boundary"<<std::endl;
+	   return false;
+    }
+/*
+        std::cout << "Hit position (id: " << detector.geographicalId().rawId() << "; " << simTrackId << ")= " 
+        << localPosition.x() << " " 
+        << localPosition.y() << " " 
+//        << sqrt(localPosition.x()*localPosition.x() + localPosition.y()*localPosition.y()) << " " 
+        << localPosition.z() << std::endl;
+*/
+    addHit(particle.charge(),betaGamma,kineticEnergy,pdgId,simTrackId,detector,localPosition,localMomentum,detector.surface().toGlobal(localPosition),refPos,random);
+    return true;
+}
+
+void fastsim::TrackerSimHitProducer::addHit(double charge,double betaGamma,double kineticEnergy,int pdgId,int simTrackId,const GeomDet & detector,const LocalPoint & localPosition,const LocalVector & localMomentum,const GlobalPoint & hitPos,const GlobalPoint & refPos,CLHEP::HepRandomEngine & random)
+{
+    // 
+    // find entry and exit point of particle in detector
+    //
+    float halfThick = 0.5*detector.surface().bounds().thickness();
+    float pZ = localMomentum.z();
+    LocalPoint entry = localPosition + (-halfThick/pZ) * localMomentum;
+    LocalPoint exit = localPosition + halfThick/pZ * localMomentum;
+
+    //
+    // create the hit
+    //
+    // energy deposit on the path through the module
+    // (xi, the width of the Landau distribution, scales with charge^2: see EnergyDepositTable)
+    double energyDeposit = 0.;
+    if(charge != 0)
+    {
+	double pathLength = 2.*halfThick*localMomentum.mag()/std::abs(pZ);
+	energyDeposit = energyDepositTable_.sample(betaGamma,charge*charge*pathLength,kineticEnergy,random.flat());
+    }
+
+    float tof = hitPos.mag() / 29.9792458 ; // in nanoseconds
+
+    distAndHits_.emplace_back(std::piecewise_construct,
+                              std::forward_as_tuple((hitPos-refPos).mag()),
+                              std::forward_as_tuple(entry, exit, localMomentum.mag(), tof, energyDeposit, pdgId,
+                                                    detector.geographicalId().rawId(),simTrackId,
+                                                    localMomentum.theta(),
+                                                    localMomentum.phi()));
+}
+
+void fastsim::TrackerSimHitProducer::Crossings::resize(unsigned size)
+{
+    x.resize(size);
+    y.resize(size);
+    z.resize(size);
+    localX.resize(size);
+    localY.resize(size);
+    localZ.resize(size);
+    localDirectionX.resize(size);
+    localDirectionY.resize(size);
+    localDirectionZ.resize(size);
+    converged.resize(size);
+    inBounds.resize(size);
+}
+
+// Batched scalar solver: the crossings with all candidate modules are computed in one loop over the module planes
+// (structure of arrays, see ModuleIndex::Planes), one module after the other,
+// without virtual calls and without the tracking tools (HelixArbitraryPlaneCrossing is only used for the crossings that do not converge).
+// The loop is not vectorized (sin/cos calls and branches), the gain is the batching alone.
+// The helix of the particle, with s the path length from its position, sT = s * sinTheta the transverse path length
+// and a = rho * sT the change of its direction in phi, is
+//   x(s) = x0 + sT * sinc(a/2) * cos(phi0 + a/2)
+//   y(s) = y0 + sT * sinc(a/2) * sin(phi0 + a/2)
+//   z(s) = z0 + s * cosTheta
+// (which is also valid for neutral particles, rho = 0).
+// Starting from the crossing of the straight line with the plane, the distance to the plane along its normal is minimized with Newton's method.
+void fastsim::TrackerSimHitProducer::crossModules(const GlobalTrajectoryParameters & particle,const ModuleIndex & moduleIndex)
+{
+    const ModuleIndex::Planes & planes = moduleIndex.planes();
+    const double x0 = particle.position().x(), y0 = particle.position().y(), z0 = particle.position().z();
+    const double p = particle.momentum().mag();
+    const double sinTheta = particle.momentum().perp()/p;
+    const double cosTheta = particle.momentum().z()/p;
+    const double phi0 = particle.momentum().phi();
+    const double cosPhi0 = std::cos(phi0), sinPhi0 = std::sin(phi0);
+    const double rho = particle.transverseCurvature();
+
+    const unsigned size = moduleIndices_.size();
+    crossings_.resize(size);
+    for(unsigned i = 0;i < size;++i)
+    {
+	const unsigned m = moduleIndices_[i];
+	const double ox = planes.x[m], oy = planes.y[m], oz = planes.z[m];
+	// normal of the plane: local z axis
+	const double nx = planes.rzx[m], ny = planes.rzy[m], nz = planes.rzz[m];
+
+	// crossing of the straight line
+	double s = ((ox - x0)*nx + (oy - y0)*ny + (oz - z0)*nz)/(sinTheta*(cosPhi0*nx + sinPhi0*ny) + cosTheta*nz);
+	double x = 0, y = 0, z = 0, dx = 0, dy = 0, dz = 0;
+	for(unsigned iteration = 0;iteration <= newtonIterations_;++iteration)
+	{
+	    const double halfAngle = 0.5*rho*s*sinTheta;
+	    const double sinc = halfAngle != 0 ? std::sin(halfAngle)/halfAngle : 1.;
+	    const double chord = s*sinTheta*sinc;
+	    x = x0 + chord*std::cos(phi0 + halfAngle);
+	    y = y0 + chord*std::sin(phi0 + halfAngle);
+	    z = z0 + s*cosTheta;
+	    dx = sinTheta*std::cos(phi0 + 2.*halfAngle);
+	    dy = sinTheta*std::sin(phi0 + 2.*halfAngle);
+	    dz = cosTheta;
+	    if(iteration < newtonIterations_)
+	    {
+		s -= ((x - ox)*nx + (y - oy)*ny + (z - oz)*nz)/(dx*nx + dy*ny + dz*nz);
+	    }
+	}
+
+	// to the coordinate system of the module
+	const double rx = x - ox, ry = y - oy, rz = z - oz;
+	const double localX = planes.rxx[m]*rx + planes.rxy[m]*ry + planes.rxz[m]*rz;
+	const double localY = planes.ryx[m]*rx + planes.ryy[m]*ry + planes.ryz[m]*rz;
+	const double localZ = nx*rx + ny*ry + nz*rz;
+	crossings_.x[i] = x;
+	crossings_.y[i] = y;
+	crossings_.z[i] = z;
+	crossings_.localX[i] = localX;
+	crossings_.localY[i] = localY;
+	crossings_.localZ[i] = localZ;
+	crossings_.localDirectionX[i] = planes.rxx[m]*dx + planes.rxy[m]*dy + planes.rxz[m]*dz;
+	crossings_.localDirectionY[i] = planes.ryx[m]*dx + planes.ryy[m]*dy + planes.ryz[m]*dz;
+	crossings_.localDirectionZ[i] = nx*dx + ny*dy + nz*dz;
+	// (false if the iteration did not give a number, e.g. for a particle moving parallel to the plane)
+	crossings_.converged[i] = std::abs(localZ) < crossingTolerance_;
+	crossings_.inBounds[i] = std::abs(localY) <= planes.halfLength[m] && std::abs(localX) <= planes.halfWidth[m]*(1. - localY*planes.trapezoid[m]);
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef FASTSIM_SYNTHETICBARRELLAYER_H
+#define FASTSIM_SYNTHETICBARRELLAYER_H
+
+#include "FastSimulation/NewParticle/interface/Particle.h"
+#include "Geometry/CommonDetUnit/interface/GeomDet.h"
+#include "DataFormats/GeometrySurface/interface/Plane.h"
+#include "DataFormats/GeometrySurface/interface/RectangularPlaneBounds.h"
+#include "DataFormats/DetId/interface/DetId.h"
+#include "CLHEP/Random/JamesRandom.h"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+// tracker modules and particles for the tests of TrackerSimHitProducer, built without tracker geometry
+namespace fastsim
+{
+    namespace test
+    {
+	// a module with a given DetId
+	class TestModule : public GeomDet
+	{
+	public:
+	    TestModule(Plane * plane,DetId detId) : GeomDet(plane) {setDetId(detId);}
+	};
+
+	// a TIB-like barrel layer at r = 25 cm: 30 overlapping 300 micron thick modules in phi (staggered in r), 6 in z
+	inline std::vector<std::unique_ptr<TestModule> > syntheticBarrelLayer()
+	{
+	    std::vector<std::unique_ptr<TestModule> > modules;
+	    const unsigned nPhi = 30, nZ = 6;
+	    for(unsigned iPhi = 0;iPhi < nPhi;++iPhi)
+	    {
+		double phi = 2.*M_PI*iPhi/nPhi;
+		double r = iPhi % 2 ? 25.2 : 24.8;
+		double c = std::cos(phi), s = std::sin(phi);
+		for(unsigned iZ = 0;iZ < nZ;++iZ)
+		{
+		    double z = -30. + 12.*iZ;
+		    // rows: local x along phi, local y along z, local z (the normal) outwards
+		    Surface::RotationType rotation(-s,c,0.,
+						   0.,0.,1.,
+						   c,s,0.);
+		    Plane * plane = new Plane(Surface::PositionType(r*c,r*s,z),rotation,new RectangularPlaneBounds(3.,6.,0.015));
+		    // TIB (subdetector 3)
+		    modules.emplace_back(new TestModule(plane,DetId(DetId(DetId::Tracker,3).rawId() + iPhi*nZ + iZ)));
+		}
+	    }
+	    return modules;
+	}
+
+	// charged pions on the layer, 0.5 - 5 GeV, |eta| < 1
+	inline std::vector<Particle> syntheticPions(unsigned n)
+	{
+	    const double pionMass = 0.13957;
+	    CLHEP::HepJamesRandom engine(4321);
+	    std::vector<Particle> particles;
+	    for(unsigned i = 0;i < n;++i)
+	    {
+		double phi = 2.*M_PI*engine.flat();
+		double eta = 2.*engine.flat() - 1.;
+		double pT = 0.5 + 4.5*engine.flat();
+		double pz = pT*std::sinh(eta);
+		double r = 25., z = r*std::sinh(eta);
+		// (the direction turned by a few degrees with respect to the position, as for a track bent on its way out)
+		double phiMomentum = phi + (i % 2 ? 0.05 : -0.05);
+		particles.emplace_back(211,
+				       math::XYZTLorentzVector(r*std::cos(phi),r*std::sin(phi),z,0.),
+				       math::XYZTLorentzVector(pT*std::cos(phiMomentum),pT*std::sin(phiMomentum),pz,std::sqrt(pT*pT + pz*pz + pionMass*pionMass)));
+		particles.back().setCharge(i % 2 ? 1. : -1.);
+		particles.back().setSimTrackIndex(i);
+	    }
+	    return particles;
+	}
+    }
+}
+
+#endif
@@ -0,0 +1,103 @@
+#include "FastSimulation/TrackerSimHitProducer/interface/EnergyDepositTable.h"
+
+#include "Math/PdfFuncMathCore.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    // 300 microns of silicon
+    const double thickness = 0.03;
+    // minimum ionizing (e.g. pions of 500 MeV)
+    const double minimumIonizingBetaGamma = 3.6;
+    // most probable value of the standard Landau distribution
+    const double landauMostProbableValue = -0.22278;
+    // probability covered by the table (the Landau tail is cut, see EnergyDepositTable.cc)
+    const double maxProbability = 0.999;
+
+    double landauIntegral(double min,double max)
+    {
+	const unsigned n = 100;
+	double h = (max - min) / n;
+	double sum = ROOT::Math::landau_pdf(min) + ROOT::Math::landau_pdf(max);
+	for(unsigned i = 1;i < n;++i)
+	{
+	    sum += (i % 2 ? 4. : 2.) * ROOT::Math::landau_pdf(min + i * h);
+	}
+	return sum * h / 3.;
+    }
+}
+
+TEST(EnergyDepositTable, SampledDistributionIsLandau)
+{
+    fastsim::EnergyDepositTable table;
+    double mostProbableValue = table.mostProbableValue(minimumIonizingBetaGamma,thickness);
+    double width = table.width(minimumIonizingBetaGamma,thickness);
+
+    // deposits for u on a uniform grid, in bins of the standard Landau variable
+    const unsigned nSamples = 1000000;
+    const unsigned nBins = 60;
+    const double lambdaMin = -3., lambdaMax = 12.;
+    const double binWidth = (lambdaMax - lambdaMin) / nBins;
+    std::vector<double> histogram(nBins,0.);
+    for(unsigned sample = 0;sample < nSamples;++sample)
+    {
+	double deposit = table.sample(minimumIonizingBetaGamma,thickness,1.,(sample + 0.5) / nSamples);
+	double lambda = (deposit - mostProbableValue) / width + landauMostProbableValue;
+	if(lambda >= lambdaMin && lambda < lambdaMax)
+	{
+	    histogram[unsigned((lambda - lambdaMin) / binWidth)] += 1. / nSamples;
+	}
+    }
+
+    for(unsigned bin = 0;bin < nBins;++bin)
+    {
+	double expected = landauIntegral(lambdaMin + bin * binWidth,lambdaMin + (bin + 1) * binWidth) / maxProbability;
+	EXPECT_NEAR(histogram[bin],expected,0.01 * expected + 1e-4) << "bin " << bin;
+    }
+}
+
+TEST(EnergyDepositTable, MostProbableValueOfMinimumIonizingParticleIn300MicronsOfSilicon)
+{
+    // about 81 keV (22500 electron-hole pairs of 3.62 eV),
+    // see the PDG review "Passage of particles through matter", straggling functions in silicon
+    fastsim::EnergyDepositTable table;
+    EXPECT_NEAR(table.mostProbableValue(minimumIonizingBetaGamma,thickness),81e-6,0.05 * 81e-6);
+}
+
+TEST(EnergyDepositTable, SlowParticlesStop)
+{
+    fastsim::EnergyDepositTable table;
+    double kineticEnergy = 2e-3;
+    for(double u : {0.,0.5,0.99})
+    {
+	EXPECT_EQ(kineticEnergy,table.sample(0.5 * fastsim::EnergyDepositTable::minBetaGamma,thickness,kineticEnergy,u));
+    }
+}
+
+TEST(EnergyDepositTable, DepositIsAtMostTheKineticEnergy)
+{
+    fastsim::EnergyDepositTable table;
+    // beta*gamma = 0.2: the most probable deposit in 300 microns is a few MeV
+    double kineticEnergy = 1e-4;
+    for(double u : {0.,0.5,0.99})
+    {
+	EXPECT_EQ(kineticEnergy,table.sample(0.2,thickness,kineticEnergy,u));
+    }
+    EXPECT_LT(table.sample(minimumIonizingBetaGamma,thickness,1.,0.5),1.);
+}
+
+TEST(EnergyDepositTable, FermiPlateau)
+{
+    fastsim::EnergyDepositTable table;
+    double plateau = table.mostProbableValue(fastsim::EnergyDepositTable::plateauBetaGamma,thickness);
+    // beyond the grid, the table is clamped: exact, since the deposit does not depend on beta*gamma any more
+    EXPECT_NEAR(table.mostProbableValue(1e3,thickness),plateau,1e-3 * plateau);
+    EXPECT_EQ(plateau,table.mostProbableValue(1e6,thickness));
+    // relativistic rise of the most probable value, a few percent in thin silicon
+    EXPECT_GT(plateau,table.mostProbableValue(minimumIonizingBetaGamma,thickness));
+    EXPECT_LT(plateau,1.1 * table.mostProbableValue(minimumIonizingBetaGamma,thickness));
+}
@@ -0,0 +1,117 @@
+#include "FastSimulation/TrackerSimHitProducer/interface/TrackerSimHitProducer.h"
+#include "FastSimulation/TrackerSimHitProducer/test/SyntheticBarrelLayer.h"
+#include "FastSimulation/Layer/interface/ModuleIndex.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+// every allocation of the test binary is counted
+namespace
+{
+    unsigned long nAllocations = 0;
+}
+
+void * operator new(std::size_t size)
+{
+    ++nAllocations;
+    void * p = std::malloc(size ? size : 1);
+    if(!p)
+    {
+	throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void * p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void * p,std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    const double magneticFieldZ = 3.8;
+
+    class TrackerSimHitAllocationTest : public ::testing::Test
+    {
+    protected:
+	TrackerSimHitAllocationTest()
+	    : modules_(fastsim::test::syntheticBarrelLayer())
+	    , particles_(fastsim::test::syntheticPions(1000))
+	    , random_(1234)
+	{
+	    std::vector<const GeomDet *> modules;
+	    for(const auto & module : modules_)
+	    {
+		modules.push_back(module.get());
+	    }
+	    moduleIndex_.reset(new fastsim::ModuleIndex(modules,false));
+	}
+
+	// creates the hits of all particles twice: the first pass sizes the buffers of the producer,
+	// in the second the allocations are counted, and compared to the number of times the output container grows
+	void countAllocations(fastsim::TrackerSimHitProducer & producer)
+	{
+	    for(const fastsim::Particle & particle : particles_)
+	    {
+		producer.createHits(particle,*moduleIndex_,false,magneticFieldZ,random_);
+	    }
+	    nHits_ = producer.simHits().size();
+	    nAllocations_ = 0;
+	    nGrowths_ = 0;
+	    for(const fastsim::Particle & particle : particles_)
+	    {
+		std::size_t capacity = producer.simHits().capacity();
+		unsigned long allocationsBefore = nAllocations;
+		producer.createHits(particle,*moduleIndex_,false,magneticFieldZ,random_);
+		nAllocations_ += nAllocations - allocationsBefore;
+		nGrowths_ += producer.simHits().capacity() != capacity;
+	    }
+	    nHits_ = producer.simHits().size() - nHits_;
+	}
+
+	std::vector<std::unique_ptr<fastsim::test::TestModule> > modules_;
+	std::unique_ptr<fastsim::ModuleIndex> moduleIndex_;
+	std::vector<fastsim::Particle> particles_;
+	CLHEP::HepJamesRandom random_;
+	std::size_t nHits_ = 0;
+	unsigned long nAllocations_ = 0;
+	unsigned long nGrowths_ = 0;
+    };
+}
+
+TEST_F(TrackerSimHitAllocationTest, NoAllocationsPerLayerCrossing)
+{
+    edm::ParameterSet cfg;
+    fastsim::TrackerSimHitProducer producer("trackerSimHits",cfg);
+    countAllocations(producer);
+    // every particle crosses at least one module, some cross two where the modules overlap
+    EXPECT_GE(nHits_,particles_.size());
+    EXPECT_LT(nHits_,2*particles_.size());
+    // the only allocations are those of the output container, which grows geometrically
+    EXPECT_EQ(nGrowths_,nAllocations_);
+    EXPECT_LT(nAllocations_,20u);
+}
+
+TEST_F(TrackerSimHitAllocationTest, NoAllocationsPerLayerCrossingWithHelixCrossing)
+{
+    // no crossing is accepted from the batched crossing of the modules:
+    // all hits are created by createHitOnDetector, with HelixArbitraryPlaneCrossing
+    edm::ParameterSet cfg;
+    cfg.addUntrackedParameter<double>("crossingTolerance",0.);
+    fastsim::TrackerSimHitProducer producer("trackerSimHits",cfg);
+    countAllocations(producer);
+    EXPECT_GE(nHits_,particles_.size());
+    EXPECT_LT(nHits_,2*particles_.size());
+    EXPECT_EQ(nGrowths_,nAllocations_);
+    EXPECT_LT(nAllocations_,20u);
+}
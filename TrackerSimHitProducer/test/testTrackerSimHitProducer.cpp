@@ -0,0 +1,67 @@
+#include "FastSimulation/TrackerSimHitProducer/interface/TrackerSimHitProducer.h"
+#include "FastSimulation/TrackerSimHitProducer/test/SyntheticBarrelLayer.h"
+#include "FastSimulation/Layer/interface/ModuleIndex.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "DataFormats/Math/interface/deltaPhi.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+namespace
+{
+    const double magneticFieldZ = 3.8;
+    // 0.1 micron: well below the tolerance of the batched crossing (1 micron off the module plane)
+    const double positionTolerance = 1e-5;
+    const double angleTolerance = 1e-5;
+
+    // the hits of the particles on the modules, created by the producer
+    edm::PSimHitContainer createHits(const edm::ParameterSet & cfg,
+				     const std::vector<fastsim::Particle> & particles,
+				     const fastsim::ModuleIndex & moduleIndex)
+    {
+	fastsim::TrackerSimHitProducer producer("trackerSimHits",cfg);
+	CLHEP::HepJamesRandom random(1234);
+	for(const fastsim::Particle & particle : particles)
+	{
+	    producer.createHits(particle,moduleIndex,false,magneticFieldZ,random);
+	}
+	return producer.simHits();
+    }
+}
+
+TEST(TrackerSimHitProducer, BatchedCrossingMatchesHelixCrossing)
+{
+    std::vector<std::unique_ptr<fastsim::test::TestModule> > testModules = fastsim::test::syntheticBarrelLayer();
+    std::vector<const GeomDet *> modules;
+    for(const auto & module : testModules)
+    {
+	modules.push_back(module.get());
+    }
+    fastsim::ModuleIndex moduleIndex(modules,false);
+    std::vector<fastsim::Particle> particles = fastsim::test::syntheticPions(1000);
+
+    // hits from the batched crossing of the modules (crossModules)
+    edm::PSimHitContainer batchedHits = createHits(edm::ParameterSet(),particles,moduleIndex);
+    // hits from HelixArbitraryPlaneCrossing only (createHitOnDetector): no crossing of the batched solver is accepted
+    edm::ParameterSet cfg;
+    cfg.addUntrackedParameter<double>("crossingTolerance",0.);
+    edm::PSimHitContainer helixHits = createHits(cfg,particles,moduleIndex);
+
+    ASSERT_GE(batchedHits.size(),particles.size());
+    ASSERT_EQ(batchedHits.size(),helixHits.size());
+    for(unsigned i = 0;i < batchedHits.size();++i)
+    {
+	const PSimHit & batchedHit = batchedHits[i];
+	const PSimHit & helixHit = helixHits[i];
+	ASSERT_EQ(batchedHit.trackId(),helixHit.trackId()) << "hit " << i;
+	ASSERT_EQ(batchedHit.detUnitId(),helixHit.detUnitId()) << "hit " << i;
+	EXPECT_NEAR(batchedHit.localPosition().x(),helixHit.localPosition().x(),positionTolerance) << "hit " << i;
+	EXPECT_NEAR(batchedHit.localPosition().y(),helixHit.localPosition().y(),positionTolerance) << "hit " << i;
+	EXPECT_NEAR(batchedHit.localPosition().z(),helixHit.localPosition().z(),positionTolerance) << "hit " << i;
+	EXPECT_NEAR(batchedHit.thetaAtEntry(),helixHit.thetaAtEntry(),angleTolerance) << "hit " << i;
+	EXPECT_NEAR(reco::deltaPhi(batchedHit.phiAtEntry(),helixHit.phiAtEntry()),0.,angleTolerance) << "hit " << i;
+	EXPECT_NEAR(batchedHit.pabs(),helixHit.pabs(),1e-6 * helixHit.pabs()) << "hit " << i;
+    }
+}